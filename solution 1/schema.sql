@@ -6,6 +6,8 @@ CREATE EXTENSION IF NOT EXISTS btree_gist;
 
 -- Create the database schema
 -- Drop existing tables if they exist (for clean setup)
+DROP TABLE IF EXISTS group_extent CASCADE;
+DROP TABLE IF EXISTS spatial_key_grid CASCADE;
 DROP TABLE IF EXISTS inspection_region CASCADE;
 DROP TABLE IF EXISTS inspection_group CASCADE;
 
@@ -22,10 +24,24 @@ CREATE TABLE inspection_region (
     coord_x FLOAT,
     coord_y FLOAT,
     category INTEGER,
+    morton_key BIGINT,   -- Z-order cell key written by the data loader (NULL if unknown)
     PRIMARY KEY (id),
     FOREIGN KEY (group_id) REFERENCES inspection_group(id)
 );
 
+-- Create spatial_key_grid table: the grid morton_key was computed on (single row),
+-- so queries can turn crop rectangles into morton_key ranges
+CREATE TABLE spatial_key_grid (
+    id INTEGER NOT NULL DEFAULT 1 CHECK (id = 1),
+    curve TEXT NOT NULL,
+    key_order INTEGER NOT NULL,
+    min_x FLOAT NOT NULL,
+    min_y FLOAT NOT NULL,
+    max_x FLOAT NOT NULL,
+    max_y FLOAT NOT NULL,
+    PRIMARY KEY (id)
+);
+
 -- Create performance indexes for spatial queries
 -- 1. Spatial index (GIST) for 2D range queries - CRITICAL for crop operations
 CREATE INDEX idx_spatial_gist ON inspection_region 
@@ -40,8 +56,142 @@ CREATE INDEX idx_category ON inspection_region(category);
 -- 4. Composite index for proper constraint optimization
 CREATE INDEX idx_group_spatial ON inspection_region(group_id, coord_x, coord_y);
 
--- 5. Index for sorting results by (y, x)
-CREATE INDEX idx_sort ON inspection_region(coord_y, coord_x);
+-- 5. Index for sorting results by (y, x); id makes the order total so keyset
+--    pagination ((coord_y, coord_x, id) > cursor ... LIMIT n) is a single range scan
+CREATE INDEX idx_sort ON inspection_region(coord_y, coord_x, id);
+
+-- 6. Morton key index: crop rectangles become a few btree range scans on
+--    morton_key (plus morton_key IS NULL for rows the loader did not key)
+CREATE INDEX idx_morton ON inspection_region(morton_key);
+
+-- A moved point no longer lies in the cell of its stored key: drop the key so the
+-- row is found through the IS NULL branch until it is re-keyed
+CREATE OR REPLACE FUNCTION morton_key_invalidate() RETURNS trigger AS $$
+BEGIN
+    NEW.morton_key := NULL;
+    RETURN NEW;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE TRIGGER trg_morton_key_invalidate
+    BEFORE UPDATE OF coord_x, coord_y ON inspection_region
+    FOR EACH ROW
+    WHEN (OLD.coord_x IS DISTINCT FROM NEW.coord_x OR OLD.coord_y IS DISTINCT FROM NEW.coord_y)
+    EXECUTE FUNCTION morton_key_invalidate();
+
+-- Create group_extent table: bounding box of every group's points, maintained by
+-- the triggers below so proper checks read one row per group instead of
+-- aggregating the whole inspection_region table
+CREATE TABLE group_extent (
+    group_id BIGINT NOT NULL,
+    min_x FLOAT,
+    max_x FLOAT,
+    min_y FLOAT,
+    max_y FLOAT,
+    point_count BIGINT NOT NULL DEFAULT 0,
+    PRIMARY KEY (group_id),
+    FOREIGN KEY (group_id) REFERENCES inspection_group(id) ON DELETE CASCADE
+);
+
+-- 7. Extent index for proper checks: groups whose box lies inside the valid region
+CREATE INDEX idx_group_extent_box ON group_extent
+USING gist(box(point(min_x, min_y), point(max_x, max_y)));
+
+-- Recompute the extents of the given groups from their points (uses idx_group_id);
+-- groups left without points lose their row.
+-- The upsert first locks every group's row (creating it if missing), waiting for any
+-- concurrent writer of the same group to finish. The recompute then runs as a new
+-- statement, so under READ COMMITTED it sees that writer's committed points instead of
+-- failing on a duplicate key or overwriting its extent with a stale one
+CREATE OR REPLACE FUNCTION refresh_group_extent(groups BIGINT[]) RETURNS void AS $$
+BEGIN
+    INSERT INTO group_extent AS e (group_id)
+    SELECT DISTINCT g FROM unnest(groups) AS g
+    ORDER BY g
+    ON CONFLICT (group_id) DO UPDATE SET point_count = e.point_count;
+    
+    UPDATE group_extent e SET
+        min_x = a.min_x, max_x = a.max_x, min_y = a.min_y, max_y = a.max_y, point_count = a.point_count
+    FROM (SELECT group_id, MIN(coord_x) AS min_x, MAX(coord_x) AS max_x,
+                 MIN(coord_y) AS min_y, MAX(coord_y) AS max_y, COUNT(*) AS point_count
+          FROM inspection_region
+          WHERE group_id = ANY(groups)
+          GROUP BY group_id) a
+    WHERE e.group_id = a.group_id;
+    
+    DELETE FROM group_extent e
+    WHERE e.group_id = ANY(groups)
+      AND NOT EXISTS (SELECT 1 FROM inspection_region r WHERE r.group_id = e.group_id);
+END;
+$$ LANGUAGE plpgsql;
+
+-- Inserts can only grow an extent: merge each statement's new rows in one upsert
+-- (rows are locked in group order, as in refresh_group_extent, so concurrent writers do not deadlock)
+CREATE OR REPLACE FUNCTION group_extent_after_insert() RETURNS trigger AS $$
+BEGIN
+    INSERT INTO group_extent AS e (group_id, min_x, max_x, min_y, max_y, point_count)
+    SELECT group_id, MIN(coord_x), MAX(coord_x), MIN(coord_y), MAX(coord_y), COUNT(*)
+    FROM new_rows
+    WHERE group_id IS NOT NULL
+    GROUP BY group_id
+    ORDER BY group_id
+    ON CONFLICT (group_id) DO UPDATE SET
+        min_x = LEAST(e.min_x, EXCLUDED.min_x),
+        max_x = GREATEST(e.max_x, EXCLUDED.max_x),
+        min_y = LEAST(e.min_y, EXCLUDED.min_y),
+        max_y = GREATEST(e.max_y, EXCLUDED.max_y),
+        point_count = e.point_count + EXCLUDED.point_count;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Deletes may remove a group's extreme point: recompute the touched groups
+CREATE OR REPLACE FUNCTION group_extent_after_delete() RETURNS trigger AS $$
+BEGIN
+    PERFORM refresh_group_extent(ARRAY(
+        SELECT DISTINCT group_id FROM old_rows WHERE group_id IS NOT NULL));
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Updates may move points or change their group: recompute old and new groups
+CREATE OR REPLACE FUNCTION group_extent_after_update() RETURNS trigger AS $$
+BEGIN
+    PERFORM refresh_group_extent(ARRAY(
+        SELECT group_id FROM old_rows WHERE group_id IS NOT NULL
+        UNION
+        SELECT group_id FROM new_rows WHERE group_id IS NOT NULL));
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE OR REPLACE FUNCTION group_extent_after_truncate() RETURNS trigger AS $$
+BEGIN
+    DELETE FROM group_extent;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Statement-level triggers see all changed rows at once through transition tables
+-- (a trigger with transition tables may only handle one event, hence one per event)
+CREATE TRIGGER trg_group_extent_insert
+    AFTER INSERT ON inspection_region
+    REFERENCING NEW TABLE AS new_rows
+    FOR EACH STATEMENT EXECUTE FUNCTION group_extent_after_insert();
+
+CREATE TRIGGER trg_group_extent_delete
+    AFTER DELETE ON inspection_region
+    REFERENCING OLD TABLE AS old_rows
+    FOR EACH STATEMENT EXECUTE FUNCTION group_extent_after_delete();
+
+CREATE TRIGGER trg_group_extent_update
+    AFTER UPDATE ON inspection_region
+    REFERENCING OLD TABLE AS old_rows NEW TABLE AS new_rows
+    FOR EACH STATEMENT EXECUTE FUNCTION group_extent_after_update();
+
+CREATE TRIGGER trg_group_extent_truncate
+    AFTER TRUNCATE ON inspection_region
+    FOR EACH STATEMENT EXECUTE FUNCTION group_extent_after_truncate();
 
 -- Verify database setup
 SELECT 'PostgreSQL container initialized successfully with schema and indexes' as status;
\ No newline at end of file
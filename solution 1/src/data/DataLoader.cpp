@@ -6,9 +6,18 @@
 #include <filesystem>
 #include <unordered_set>
 #include <iomanip>
+#include <algorithm>
+#include <map>
 
 DataLoader::DataLoader(const std::string& data_dir, DatabaseManager& db_mgr)
-    : data_directory(data_dir), db_manager(db_mgr) {
+    : data_directory(data_dir), databases{&db_mgr} {
+}
+
+DataLoader::DataLoader(const std::string& data_dir, const std::vector<DatabaseManager*>& shard_managers)
+    : data_directory(data_dir), databases(shard_managers) {
+    if (databases.empty()) {
+        throw std::runtime_error("DataLoader needs at least one database");
+    }
 }
 
 void DataLoader::loadData() {
@@ -40,22 +49,7 @@ void DataLoader::loadData() {
     
     std::cout << "✓ Data consistency validation passed" << std::endl;
     
-    // Step 4: Verify database schema and clear existing data
-    if (!db_manager.tablesExist()) {
-        throw std::runtime_error("Required database tables do not exist. "
-                                "Please run schema setup: docker-compose exec postgres psql -U inspection_user -d inspection_db -f /schema.sql");
-    }
-    
-    std::cout << "✓ Database schema validated" << std::endl;
-    db_manager.clearTables();  // Clear any existing data
-    
-    // Step 5: Insert unique groups first (due to foreign key constraint)
-    auto unique_groups = getUniqueGroups(groups);
-    std::cout << "Found " << unique_groups.size() << " unique groups" << std::endl;
-    
-    db_manager.insertGroups(unique_groups);
-    
-    // Step 6: Prepare points data
+    // Step 4: Prepare points data
     std::vector<Point> point_data;
     point_data.reserve(points.size());
     
@@ -70,10 +64,59 @@ void DataLoader::loadData() {
         point_data.push_back(point);
     }
     
-    // Step 7: Insert all points
-    db_manager.insertPoints(point_data);
+    auto unique_groups = getUniqueGroups(groups);
+    std::cout << "Found " << unique_groups.size() << " unique groups" << std::endl;
+    
+    // One Morton grid over all points, so keys agree across shards
+    MortonGrid grid = MortonGrid::fromPoints(point_data);
     
-    // Step 8: Verify data was loaded correctly
+    if (databases.size() == 1) {
+        loadDatabase(*databases[0], unique_groups, point_data, grid);
+    } else {
+        // Step 5: Distribute whole groups over the shards
+        auto shard_of_group = assignGroupsToShards(point_data, grid, databases.size());
+        
+        std::vector<std::vector<int64_t>> shard_groups(databases.size());
+        std::vector<std::vector<Point>> shard_points(databases.size());
+        for (int64_t group_id : unique_groups) {
+            shard_groups[shard_of_group[group_id]].push_back(group_id);
+        }
+        for (const auto& point : point_data) {
+            shard_points[shard_of_group[point.group_id]].push_back(point);
+        }
+        
+        for (size_t s = 0; s < databases.size(); ++s) {
+            std::cout << std::endl << "=== Shard " << s << ": " << shard_groups[s].size() << " groups, "
+                      << shard_points[s].size() << " points ===" << std::endl;
+            loadDatabase(*databases[s], shard_groups[s], shard_points[s], grid);
+        }
+    }
+    
+    std::cout << "✅ Data loading completed successfully!" << std::endl;
+}
+
+void DataLoader::loadDatabase(DatabaseManager& db_manager, const std::vector<int64_t>& group_ids,
+                              const std::vector<Point>& points, const MortonGrid& grid) {
+    // Verify database schema and clear existing data
+    if (!db_manager.tablesExist()) {
+        throw std::runtime_error("Required database tables do not exist. "
+                                "Please run schema setup: docker-compose exec postgres psql -U inspection_user -d inspection_db -f /schema.sql");
+    }
+    
+    std::cout << "✓ Database schema validated" << std::endl;
+    db_manager.clearTables();  // Clear any existing data
+    
+    // Insert groups first (due to foreign key constraint)
+    db_manager.insertGroups(group_ids);
+    
+    // Insert all points with their Morton keys, and record the key grid
+    db_manager.insertPoints(points, grid);
+    db_manager.storeKeyGrid(grid);
+    
+    // Refresh statistics and visibility map for the query planner
+    db_manager.analyzeTables();
+    
+    // Verify data was loaded correctly
     size_t groups_count = db_manager.getTableCount("inspection_group");
     size_t points_count = db_manager.getTableCount("inspection_region");
     
@@ -81,13 +124,48 @@ void DataLoader::loadData() {
     std::cout << "Groups in database: " << groups_count << std::endl;
     std::cout << "Points in database: " << points_count << std::endl;
     
-    if (points_count == points.size() && groups_count == unique_groups.size()) {
-        std::cout << "✅ Data loading completed successfully!" << std::endl;
-    } else {
+    if (points_count != points.size() || groups_count != group_ids.size()) {
         throw std::runtime_error("Data loading verification failed");
     }
 }
 
+std::unordered_map<int64_t, size_t> DataLoader::assignGroupsToShards(const std::vector<Point>& points,
+                                                                    const MortonGrid& grid, size_t shard_count) {
+    struct GroupStats {
+        double sum_x = 0.0;
+        double sum_y = 0.0;
+        size_t count = 0;
+    };
+    
+    std::map<int64_t, GroupStats> stats;
+    for (const auto& point : points) {
+        GroupStats& group = stats[point.group_id];
+        group.sum_x += point.coord_x;
+        group.sum_y += point.coord_y;
+        ++group.count;
+    }
+    
+    // Order groups along the Z-curve by centroid
+    std::vector<std::pair<int64_t, int64_t>> keyed_groups;  // (centroid key, group ID)
+    keyed_groups.reserve(stats.size());
+    for (const auto& [group_id, group] : stats) {
+        keyed_groups.emplace_back(grid.key(group.sum_x / group.count, group.sum_y / group.count), group_id);
+    }
+    std::sort(keyed_groups.begin(), keyed_groups.end());
+    
+    // Cut into runs of about points.size() / shard_count points each
+    std::unordered_map<int64_t, size_t> shard_of_group;
+    size_t assigned_points = 0;
+    for (const auto& [key, group_id] : keyed_groups) {
+        size_t count = stats[group_id].count;
+        size_t shard = std::min(shard_count - 1, (assigned_points + count / 2) * shard_count / points.size());
+        shard_of_group[group_id] = shard;
+        assigned_points += count;
+    }
+    
+    return shard_of_group;
+}
+
 bool DataLoader::validateFiles() {
     std::vector<std::string> required_files = {"points.txt", "categories.txt", "groups.txt"};
     
@@ -3,6 +3,8 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <unordered_map>
+#include "../data/MortonKey.h"
 #include "../data/Point.h"
 #include "../database/DatabaseManager.h"
 
@@ -12,7 +14,7 @@
 class DataLoader {
 private:
     std::string data_directory;
-    DatabaseManager& db_manager;
+    std::vector<DatabaseManager*> databases;  // One per shard (a single entry when not sharded)
 
 public:
     /**
@@ -22,6 +24,14 @@ public:
      */
     DataLoader(const std::string& data_dir, DatabaseManager& db_mgr);
     
+    /**
+     * Initialize data loader for a sharded deployment
+     * Every group is stored whole on exactly one shard, so proper checks stay local
+     * @param data_dir Path to directory containing data files
+     * @param shard_managers Database managers of the shards (must outlive the loader)
+     */
+    DataLoader(const std::string& data_dir, const std::vector<DatabaseManager*>& shard_managers);
+    
     /**
      * Load all data from the directory into the database
      * This is the main entry point for Task 1
@@ -35,6 +45,29 @@ public:
     bool validateFiles();
     
 private:
+    /**
+     * Replace the contents of one database with the given groups and points
+     * @param db_manager Target database
+     * @param group_ids Groups to insert
+     * @param points Points to insert (all belong to group_ids)
+     * @param grid Morton grid of the whole data set (identical on every shard)
+     */
+    void loadDatabase(DatabaseManager& db_manager, const std::vector<int64_t>& group_ids,
+                      const std::vector<Point>& points, const MortonGrid& grid);
+    
+    /**
+     * Assign each group to a shard
+     * Groups are ordered by the Morton key of their centroid and cut into
+     * contiguous runs of roughly equal point counts, so each shard covers a
+     * compact area and crops touch few shards.
+     * @param points All points
+     * @param grid Morton grid of the whole data set
+     * @param shard_count Number of shards
+     * @return Shard index per group ID
+     */
+    static std::unordered_map<int64_t, size_t> assignGroupsToShards(const std::vector<Point>& points,
+                                                                   const MortonGrid& grid, size_t shard_count);
+    
     /**
      * Parse points.txt file
      * @return Vector of coordinate pairs
@@ -0,0 +1,52 @@
+#include "MortonKey.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+MortonGrid MortonGrid::fromPoints(const std::vector<Point>& points, int order) {
+    if (points.empty()) {
+        throw std::runtime_error("Cannot build a Morton grid without points");
+    }
+    if (order < 1 || order > 31) {
+        throw std::runtime_error("Morton grid order must be between 1 and 31");
+    }
+    
+    MortonGrid grid;
+    grid.order = order;
+    grid.min_x = grid.max_x = points[0].coord_x;
+    grid.min_y = grid.max_y = points[0].coord_y;
+    
+    for (const auto& point : points) {
+        grid.min_x = std::min(grid.min_x, point.coord_x);
+        grid.max_x = std::max(grid.max_x, point.coord_x);
+        grid.min_y = std::min(grid.min_y, point.coord_y);
+        grid.max_y = std::max(grid.max_y, point.coord_y);
+    }
+    
+    return grid;
+}
+
+int64_t MortonGrid::key(double x, double y) const {
+    // Spread the bits of a 32-bit value so they occupy the even positions
+    auto spread = [](uint64_t v) {
+        v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+        v = (v | (v << 8)) & 0x00FF00FF00FF00FFull;
+        v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0Full;
+        v = (v | (v << 2)) & 0x3333333333333333ull;
+        v = (v | (v << 1)) & 0x5555555555555555ull;
+        return v;
+    };
+    
+    uint64_t cell_x = cell(x, min_x, max_x);
+    uint64_t cell_y = cell(y, min_y, max_y);
+    return static_cast<int64_t>(spread(cell_x) | (spread(cell_y) << 1));
+}
+
+uint32_t MortonGrid::cell(double value, double min_value, double max_value) const {
+    // Must match SpaceFillingCurve::cellX/cellY in solution 2 exactly
+    double extent = max_value - min_value;
+    if (extent <= 0.0) return 0;
+    uint32_t cells_per_axis = 1u << order;
+    double cell = std::floor((value - min_value) / extent * cells_per_axis);
+    return static_cast<uint32_t>(std::clamp(cell, 0.0, static_cast<double>(cells_per_axis - 1)));
+}
\ No newline at end of file
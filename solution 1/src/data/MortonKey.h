@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Point.h"
+
+/**
+ * Grid that maps points to 64-bit Morton (Z-order) keys
+ *
+ * The data bounds are split into 2^order cells per axis; a point's key
+ * interleaves the bits of its cell column (even bits) and row (odd bits).
+ * The grid is stored in spatial_key_grid so the query side can decompose crop
+ * rectangles into key ranges with the same cell arithmetic.
+ */
+struct MortonGrid {
+    double min_x = 0.0;
+    double min_y = 0.0;
+    double max_x = 0.0;
+    double max_y = 0.0;
+    int order = 31;  // Bits per axis; 2 * 31 bits keep keys positive in a BIGINT
+    
+    /**
+     * Build the grid over the bounding box of the points
+     * @param points Points to cover (must not be empty)
+     * @param order Bits per axis (1..31)
+     */
+    static MortonGrid fromPoints(const std::vector<Point>& points, int order = 31);
+    
+    /**
+     * Get the Morton key of the cell containing (x, y); coordinates outside
+     * the bounds are clamped to the border cells
+     */
+    int64_t key(double x, double y) const;
+    
+private:
+    uint32_t cell(double value, double min_value, double max_value) const;
+};
\ No newline at end of file
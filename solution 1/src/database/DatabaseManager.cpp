@@ -1,6 +1,7 @@
 #include "DatabaseManager.h"
 #include <iostream>
 #include <sstream>
+#include <iomanip>
 #include <stdexcept>
 #include <unordered_set>
 
@@ -139,7 +140,7 @@ void DatabaseManager::insertPoint(const Point& point) {
     }
 }
 
-void DatabaseManager::insertPoints(const std::vector<Point>& points) {
+void DatabaseManager::insertPoints(const std::vector<Point>& points, const std::optional<MortonGrid>& grid) {
     if (points.empty()) return;
     
     try {
@@ -147,9 +148,12 @@ void DatabaseManager::insertPoints(const std::vector<Point>& points) {
         
         std::cout << "Inserting " << points.size() << " points..." << std::endl;
         
-        // Use batch INSERT for better performance
+        // Use batch INSERT for better performance; coordinates are written with full
+        // precision so the stored values (and their Morton cells) match the parsed ones
         std::stringstream query;
-        query << "INSERT INTO inspection_region (id, group_id, coord_x, coord_y, category) VALUES ";
+        query << std::setprecision(17);
+        query << "INSERT INTO inspection_region (id, group_id, coord_x, coord_y, category"
+              << (grid ? ", morton_key" : "") << ") VALUES ";
         
         for (size_t i = 0; i < points.size(); ++i) {
             if (i > 0) query << ", ";
@@ -157,7 +161,11 @@ void DatabaseManager::insertPoints(const std::vector<Point>& points) {
                   << points[i].group_id << ", " 
                   << points[i].coord_x << ", " 
                   << points[i].coord_y << ", " 
-                  << points[i].category << ")";
+                  << points[i].category;
+            if (grid) {
+                query << ", " << grid->key(points[i].coord_x, points[i].coord_y);
+            }
+            query << ")";
         }
         
         txn.exec(query.str());
@@ -170,6 +178,24 @@ void DatabaseManager::insertPoints(const std::vector<Point>& points) {
     }
 }
 
+void DatabaseManager::storeKeyGrid(const MortonGrid& grid) {
+    try {
+        pqxx::work txn(*connection);
+        
+        txn.exec_params("INSERT INTO spatial_key_grid (id, curve, key_order, min_x, min_y, max_x, max_y) "
+                       "VALUES (1, 'morton', $1, $2, $3, $4, $5) "
+                       "ON CONFLICT (id) DO UPDATE SET curve = EXCLUDED.curve, key_order = EXCLUDED.key_order, "
+                       "min_x = EXCLUDED.min_x, min_y = EXCLUDED.min_y, max_x = EXCLUDED.max_x, max_y = EXCLUDED.max_y",
+                       grid.order, grid.min_x, grid.min_y, grid.max_x, grid.max_y);
+        
+        txn.commit();
+        std::cout << "Morton key grid stored (order " << grid.order << ")." << std::endl;
+        
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Failed to store key grid: " + std::string(e.what()));
+    }
+}
+
 pqxx::connection& DatabaseManager::getConnection() {
     return *connection;
 }
@@ -197,4 +223,18 @@ size_t DatabaseManager::getTableCount(const std::string& table_name) {
     } catch (const std::exception& e) {
         throw std::runtime_error("Failed to get table count: " + std::string(e.what()));
     }
+}
+
+void DatabaseManager::analyzeTables() {
+    try {
+        // VACUUM cannot run inside a transaction block
+        pqxx::nontransaction txn(*connection);
+        
+        std::cout << "Vacuuming and analyzing tables..." << std::endl;
+        txn.exec("VACUUM ANALYZE inspection_group");
+        txn.exec("VACUUM ANALYZE inspection_region");
+        
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Failed to analyze tables: " + std::string(e.what()));
+    }
 }
\ No newline at end of file
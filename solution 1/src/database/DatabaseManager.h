@@ -1,10 +1,12 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 #include <pqxx/pqxx>
 #include "../data/Point.h"
+#include "../data/MortonKey.h"
 
 /**
  * Manages PostgreSQL database connections and operations
@@ -65,8 +67,15 @@ public:
     /**
      * Insert multiple points efficiently using batch operations
      * @param points Vector of points to insert
+     * @param grid Optional Morton grid; when given, each row also gets its morton_key
      */
-    void insertPoints(const std::vector<Point>& points);
+    void insertPoints(const std::vector<Point>& points, const std::optional<MortonGrid>& grid = std::nullopt);
+    
+    /**
+     * Record the Morton grid used for morton_key so queries can decompose rectangles consistently
+     * @param grid Grid the keys were computed with
+     */
+    void storeKeyGrid(const MortonGrid& grid);
     
     /**
      * Get database connection for advanced operations
@@ -88,6 +97,12 @@ public:
      */
     size_t getTableCount(const std::string& table_name);
     
+    /**
+     * Refresh planner statistics and the visibility map after a bulk load
+     * (index-only scans skip heap fetches only for all-visible pages)
+     */
+    void analyzeTables();
+    
 private:
     /**
      * Prepare commonly used SQL statements for better performance
@@ -0,0 +1,171 @@
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <gflags/gflags.h>
+#include "../backend/CropFilter.h"
+
+// Define command line flags
+DEFINE_int32(points, 2000000, "Number of generated points to filter");
+DEFINE_int32(repeats, 10, "Passes over the points per variant (the best pass is reported)");
+DEFINE_int32(seed, 42, "Random seed");
+
+/**
+ * Crop filter microbenchmark
+ *
+ * Runs each of the eight filter variants (category x group set x excluded
+ * set) over the same points twice: once through the run-time checked
+ * CropFilter::accepts and once through the FilterPipeline chosen by
+ * CropFilter::dispatch. Both must accept the same number of points.
+ */
+
+namespace {
+
+const int CATEGORY_COUNT = 10;
+const int GROUP_SIZE = 37;
+
+struct VariantReport {
+    std::string name;
+    size_t accepted = 0;
+    double runtime_ns = 0.0;      // Per point, run-time checked
+    double specialized_ns = 0.0;  // Per point, compile-time specialized
+};
+
+std::vector<Point> generatePoints(std::mt19937& rng) {
+    std::uniform_real_distribution<double> coord(0.0, 1000.0);
+    std::uniform_int_distribution<int> category(0, CATEGORY_COUNT - 1);
+    
+    std::vector<Point> points;
+    points.reserve(FLAGS_points);
+    for (int i = 0; i < FLAGS_points; ++i) {
+        points.emplace_back(coord(rng), coord(rng), i + 1, i / GROUP_SIZE, category(rng));
+    }
+    return points;
+}
+
+/**
+ * Filter with the conditions of one variant switched on
+ * @param variant Bit 0 = categories, bit 1 = group set, bit 2 = excluded set
+ */
+CropFilter makeFilter(int variant, long long group_count, std::mt19937& rng) {
+    CropFilter filter;
+    if (variant & 1) {
+        filter.categories = {1, 4, 7};
+    }
+    if (variant & 2) {
+        // Group filter or proper: true - about a third of the groups
+        filter.restrict_groups = true;
+        for (long long group = 0; group < group_count; ++group) {
+            if (rng() % 3 == 0) filter.groups.insert(group);
+        }
+    }
+    if (variant & 4) {
+        // proper: false - about a fifth of the groups are proper and dropped
+        for (long long group = 0; group < group_count; ++group) {
+            if (rng() % 5 == 0) filter.excluded.insert(group);
+        }
+    }
+    return filter;
+}
+
+std::string variantName(int variant) {
+    std::string name;
+    if (variant & 1) name += "category";
+    if (variant & 2) name += name.empty() ? "groups" : " + groups";
+    if (variant & 4) name += name.empty() ? "excluded" : " + excluded";
+    return name.empty() ? "none" : name;
+}
+
+/**
+ * Best time of FLAGS_repeats passes, in nanoseconds per point
+ */
+template <typename Pass>
+double bestPass(const Pass& pass, size_t point_count, size_t& accepted) {
+    double best = 0.0;
+    for (int r = 0; r < FLAGS_repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        accepted = pass();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        best = r == 0 ? ns : std::min(best, ns);
+    }
+    return best / std::max<size_t>(1, point_count);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    gflags::SetUsageMessage("Crop Filter Benchmark\n"
+                           "Compares run-time checked and compile-time specialized crop filters.\n\n"
+                           "Examples:\n"
+                           "  " + std::string(argv[0]) + "\n"
+                           "  " + std::string(argv[0]) + " --points=10000000 --repeats=5");
+    
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    
+    if (FLAGS_points <= 0 || FLAGS_repeats <= 0) {
+        std::cerr << "Error: --points and --repeats must be positive" << std::endl;
+        return 1;
+    }
+    
+    std::mt19937 rng(FLAGS_seed);
+    std::cout << "Generating " << FLAGS_points << " points..." << std::endl;
+    std::vector<Point> points = generatePoints(rng);
+    long long group_count = points.back().group_id + 1;
+    
+    std::vector<Point> out;
+    out.reserve(points.size());
+    
+    std::vector<VariantReport> reports;
+    for (int variant = 0; variant < 8; ++variant) {
+        CropFilter filter = makeFilter(variant, group_count, rng);
+        VariantReport report;
+        report.name = variantName(variant);
+        
+        // Both loops copy accepted points out, like the backends' scans
+        size_t runtime_accepted = 0;
+        report.runtime_ns = bestPass([&]() {
+            out.clear();
+            for (const auto& point : points) {
+                if (filter.accepts(point)) {
+                    out.push_back(point);
+                }
+            }
+            return out.size();
+        }, points.size(), runtime_accepted);
+        
+        report.specialized_ns = bestPass([&]() {
+            out.clear();
+            filter.dispatch([&](const auto& accepts) {
+                for (const auto& point : points) {
+                    if (accepts(point)) {
+                        out.push_back(point);
+                    }
+                }
+            });
+            return out.size();
+        }, points.size(), report.accepted);
+        
+        if (report.accepted != runtime_accepted) {
+            std::cerr << "Error: variant " << report.name << " accepted " << report.accepted
+                      << " points specialized but " << runtime_accepted << " at run time" << std::endl;
+            return 1;
+        }
+        reports.push_back(report);
+    }
+    
+    std::cout << std::endl << "=== Crop Filter Benchmark (" << points.size() << " points) ===" << std::endl;
+    std::cout << std::left << std::setw(28) << "variant" << std::right << std::setw(12) << "accepted"
+              << std::setw(14) << "runtime ns" << std::setw(16) << "specialized ns" << std::setw(10) << "speedup" << std::endl;
+    for (const auto& r : reports) {
+        std::cout << std::left << std::setw(28) << r.name << std::right << std::fixed
+                  << std::setw(12) << r.accepted
+                  << std::setw(14) << std::setprecision(2) << r.runtime_ns
+                  << std::setw(16) << std::setprecision(2) << r.specialized_ns
+                  << std::setw(9) << std::setprecision(2) << r.runtime_ns / std::max(1e-9, r.specialized_ns) << "x"
+                  << std::endl;
+    }
+    
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "ColumnarBackend.h"
+#include "../geometry/ScanKernel.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+// Rows per filter block: small enough that a block's columns stay in L1
+constexpr size_t BLOCK_SIZE = ZoneMap::BLOCK_SIZE;
+
+}
+
+ColumnarBackend::ColumnarBackend(const std::vector<Point>& points) : InMemoryBackend(points) {
+    std::vector<Point> sorted = points;
+    std::sort(sorted.begin(), sorted.end());
+    
+    xs.reserve(sorted.size());
+    ys.reserve(sorted.size());
+    ids.reserve(sorted.size());
+    group_ids.reserve(sorted.size());
+    categories.reserve(sorted.size());
+    
+    for (const auto& point : sorted) {
+        xs.push_back(point.x);
+        ys.push_back(point.y);
+        ids.push_back(point.id);
+        group_ids.push_back(point.group_id);
+        categories.push_back(point.category);
+    }
+    zones = ZoneMap(sorted);
+    
+    std::cout << "Column store built: " << ys.size() << " rows, " << zones.blockCount() << " zones" << std::endl;
+}
+
+size_t ColumnarBackend::firstRowAfter(const KeysetCursor& after) const {
+    size_t low = std::lower_bound(ys.begin(), ys.end(), after.y) - ys.begin();
+    size_t high = std::upper_bound(ys.begin() + low, ys.end(), after.y) - ys.begin();
+    
+    // Within the rows at y == after.y, order is (x, id)
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        bool before_or_at = xs[mid] < after.x || (xs[mid] == after.x && ids[mid] <= after.id);
+        if (before_or_at) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+size_t ColumnarBackend::memoryUsage() const {
+    return xs.capacity() * sizeof(double) + ys.capacity() * sizeof(double) +
+           ids.capacity() * sizeof(long long) + group_ids.capacity() * sizeof(long long) +
+           categories.capacity() * sizeof(int) + zones.memoryUsage();
+}
+
+void ColumnarBackend::planSearch(const Rectangle& crop, const CropFilter& filter, std::vector<SearchRange>& ranges) const {
+    // The band of rows with crop.min_y <= y <= crop.max_y
+    size_t first = std::lower_bound(ys.begin(), ys.end(), crop.p_min.y) - ys.begin();
+    size_t last = std::upper_bound(ys.begin() + first, ys.end(), crop.p_max.y) - ys.begin();
+    
+    if (filter.after.has_value()) {
+        first = std::max(first, firstRowAfter(filter.after.value()));
+    }
+    if (first < last) {
+        ranges.push_back({first, last, 0});
+    }
+}
+
+void ColumnarBackend::scanRanges(const Rectangle& crop, const CropFilter& filter, const std::vector<SearchRange>& ranges,
+                                 std::vector<Point>& out, size_t max_results) const {
+    ZoneMap::Probe probe(zones, crop, filter);
+    
+    // Categories are tested per block by the scan kernel, so the pipeline skips them
+    filter.dispatch<false>([&](const auto& accepts) {
+        for (const auto& range : ranges) {
+            scanBand(range.first, range.last, crop, probe, filter.categories, accepts, out, max_results);
+        }
+    });
+}
+
+template <typename Accept>
+void ColumnarBackend::scanBand(size_t first, size_t last, const Rectangle& crop, const ZoneMap::Probe& probe,
+                               const CategoryMask& category_filter, const Accept& accepts,
+                               std::vector<Point>& out, size_t max_results) const {
+    uint64_t mask[BLOCK_SIZE / 64];
+    
+    for (size_t block = first, end; block < last && out.size() < max_results; block = end) {
+        // Stop at zone boundaries, so each step is (part of) one zone
+        end = std::min((block / BLOCK_SIZE + 1) * BLOCK_SIZE, last);
+        size_t count = end - block;
+        
+        ZoneMap::Overlap overlap = probe.test(block);
+        if (overlap == ZoneMap::Overlap::NONE) {
+            continue;
+        }
+        
+        // Vectorized rectangle and category tests over the block, the rest per selected row
+        if (overlap == ZoneMap::Overlap::INSIDE) {
+            ScanKernel::selectAll(count, mask);
+        } else {
+            crop.containsBatch(xs.data() + block, ys.data() + block, count, mask);
+        }
+        ScanKernel::andCategoryMask(categories.data() + block, count, category_filter, mask);
+        
+        for (size_t w = 0; w < ScanKernel::maskWords(count); ++w) {
+            for (uint64_t bits = mask[w]; bits != 0; bits &= bits - 1) {
+                Point point = row(block + w * 64 + static_cast<size_t>(__builtin_ctzll(bits)));
+                if (accepts(point)) {
+                    out.push_back(point);
+                    if (out.size() >= max_results) {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
\ No newline at end of file
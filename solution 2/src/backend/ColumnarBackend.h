@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "InMemoryBackend.h"
+#include "ZoneMap.h"
+
+/**
+ * In-memory column store sorted by (y, x, id)
+ *
+ * Each attribute is a separate array in result order. A crop is two binary
+ * searches on the y column that delimit the band of candidate rows, then a
+ * block-wise x filter over that band; surviving rows are checked against the
+ * remaining filters and materialized. Rows come out already in final order, so
+ * there is no sort and a limit stops the scan early. Best for wide, short crops,
+ * where the band holds few rows outside the rectangle.
+ *
+ * A zone map over the filter blocks lets the scan skip blocks whose x range,
+ * categories or groups cannot match without reading their columns, and drop
+ * the rectangle test for blocks that lie entirely inside the crop.
+ */
+class ColumnarBackend : public InMemoryBackend {
+private:
+    std::vector<double> xs;
+    std::vector<double> ys;
+    std::vector<long long> ids;
+    std::vector<long long> group_ids;
+    std::vector<int> categories;
+    ZoneMap zones;
+
+public:
+    /**
+     * Sort the snapshot by (y, x, id) and split it into columns
+     * @param points Snapshot of all points
+     */
+    explicit ColumnarBackend(const std::vector<Point>& points);
+    
+    std::string getName() const override { return "columnar"; }
+    
+    size_t memoryUsage() const override;
+    
+    size_t size() const override { return ys.size(); }
+
+protected:
+    void planSearch(const Rectangle& crop, const CropFilter& filter, std::vector<SearchRange>& ranges) const override;
+    
+    void scanRanges(const Rectangle& crop, const CropFilter& filter, const std::vector<SearchRange>& ranges,
+                    std::vector<Point>& out, size_t max_results) const override;
+    
+    bool searchIsSorted() const override { return true; }
+
+private:
+    Point row(size_t i) const { return Point(xs[i], ys[i], ids[i], group_ids[i], categories[i]); }
+    
+    /**
+     * First row strictly after the cursor in (y, x, id) order
+     */
+    size_t firstRowAfter(const KeysetCursor& after) const;
+    
+    /**
+     * Filter rows [first, last) block by block, for one filter pipeline (see CropFilter::dispatch)
+     * @param probe Zone test of the crop and filter
+     * @param category_filter Categories tested with the scan kernel (empty = any)
+     * @param accepts Remaining per-row conditions
+     */
+    template <typename Accept>
+    void scanBand(size_t first, size_t last, const Rectangle& crop, const ZoneMap::Probe& probe,
+                  const CategoryMask& category_filter, const Accept& accepts, std::vector<Point>& out,
+                  size_t max_results) const;
+};
\ No newline at end of file
@@ -0,0 +1,316 @@
+#include "CompressedBackend.h"
+#include "../geometry/ScanKernel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+static_assert(PackedColumn::BLOCK_SIZE == ZoneMap::BLOCK_SIZE, "zones must match the packed blocks");
+
+namespace {
+
+const uint64_t SIGN = uint64_t(1) << 63;
+const int MAX_DIGITS = 9;
+const double MAX_EXACT = 9007199254740992.0;    // 2^53: larger codes are not exact doubles
+
+/**
+ * Signed integer with the order of the double; unlike orderedKey it keeps -0.0 apart from 0.0
+ */
+int64_t bitsCode(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint64_t key = (bits & SIGN) ? ~bits : bits | SIGN;
+    return static_cast<int64_t>(key ^ SIGN);
+}
+
+double bitsValue(int64_t code) {
+    uint64_t key = static_cast<uint64_t>(code) ^ SIGN;
+    uint64_t bits = (key & SIGN) ? key & ~SIGN : ~key;
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * Decimal fixed-point code of a value, if decoding it gives back the same bits
+ */
+bool fixedCode(double value, double scale, int64_t& code) {
+    double scaled = value * scale;
+    if (!(std::fabs(scaled) < MAX_EXACT)) {
+        return false;
+    }
+    code = std::llround(scaled);
+    double decoded = static_cast<double>(code) / scale;
+    return std::memcmp(&decoded, &value, sizeof(value)) == 0;
+}
+
+/**
+ * Smallest decimal code whose value is >= bound (decoding is monotonic, so the guess only needs a nudge)
+ */
+int64_t codeAtLeast(double bound, double scale) {
+    double guess = std::ceil(bound * scale);
+    if (guess <= -MAX_EXACT) {
+        return std::numeric_limits<int64_t>::min();
+    }
+    if (guess >= MAX_EXACT) {
+        return std::numeric_limits<int64_t>::max();
+    }
+    int64_t code = static_cast<int64_t>(guess);
+    while (static_cast<double>(code - 1) / scale >= bound) {
+        --code;
+    }
+    while (static_cast<double>(code) / scale < bound) {
+        ++code;
+    }
+    return code;
+}
+
+/**
+ * Largest decimal code whose value is <= bound
+ */
+int64_t codeAtMost(double bound, double scale) {
+    double guess = std::floor(bound * scale);
+    if (guess <= -MAX_EXACT) {
+        return std::numeric_limits<int64_t>::min();
+    }
+    if (guess >= MAX_EXACT) {
+        return std::numeric_limits<int64_t>::max();
+    }
+    int64_t code = static_cast<int64_t>(guess);
+    while (static_cast<double>(code + 1) / scale <= bound) {
+        ++code;
+    }
+    while (static_cast<double>(code) / scale > bound) {
+        --code;
+    }
+    return code;
+}
+
+} // namespace
+
+double CompressedBackend::CoordinateColumn::decode(size_t row) const {
+    int64_t code = codes.at(row);
+    return fixed_point[row / PackedColumn::BLOCK_SIZE] ? static_cast<double>(code) / scale : bitsValue(code);
+}
+
+void CompressedBackend::CoordinateColumn::andRangeMask(size_t first, size_t count, double low, double high,
+                                                       uint64_t* mask) const {
+    size_t b = first / PackedColumn::BLOCK_SIZE;
+    const PackedColumn::Block& block = codes.block(b);
+    
+    // Exact code thresholds for this block's encoding; -0.0 and 0.0 compare equal, so both bounds admit both
+    int64_t low_code, high_code;
+    if (!(low <= high)) {
+        low_code = std::numeric_limits<int64_t>::max();
+        high_code = std::numeric_limits<int64_t>::min();
+    } else if (fixed_point[b]) {
+        low_code = codeAtLeast(low, scale);
+        high_code = codeAtMost(high, scale);
+    } else {
+        low_code = bitsCode(low == 0.0 ? -0.0 : low);
+        high_code = bitsCode(high == 0.0 ? 0.0 : high);
+    }
+    
+    // Relative to the block base, clamped to what the block's width can hold
+    uint64_t width_max = block.width == 8 ? std::numeric_limits<uint64_t>::max()
+                                          : (uint64_t(1) << (8 * block.width)) - 1;
+    if (high_code < block.base || low_code > high_code) {
+        std::memset(mask, 0, ScanKernel::maskWords(count) * sizeof(uint64_t));
+        return;
+    }
+    uint64_t low_offset = low_code <= block.base ? 0 : static_cast<uint64_t>(low_code) - static_cast<uint64_t>(block.base);
+    uint64_t high_offset = std::min(width_max, static_cast<uint64_t>(high_code) - static_cast<uint64_t>(block.base));
+    if (low_offset > width_max) {
+        std::memset(mask, 0, ScanKernel::maskWords(count) * sizeof(uint64_t));
+        return;
+    }
+    
+    size_t i = first % PackedColumn::BLOCK_SIZE;
+    switch (block.width) {
+        case 2:
+            ScanKernel::andCodeRangeMask(codes.offsets16(block) + i, count, static_cast<uint16_t>(low_offset),
+                                         static_cast<uint16_t>(high_offset), mask);
+            break;
+        case 4:
+            ScanKernel::andCodeRangeMask(codes.offsets32(block) + i, count, static_cast<uint32_t>(low_offset),
+                                         static_cast<uint32_t>(high_offset), mask);
+            break;
+        default:
+            ScanKernel::andCodeRangeMask(codes.offsets64(block) + i, count, low_offset, high_offset, mask);
+            break;
+    }
+}
+
+CompressedBackend::CompressedBackend(const std::vector<Point>& points) : InMemoryBackend(points) {
+    std::vector<Point> sorted = points;
+    std::sort(sorted.begin(), sorted.end());
+    
+    std::vector<double> x_values, y_values;
+    std::vector<int64_t> id_values, group_values, category_values;
+    x_values.reserve(sorted.size());
+    y_values.reserve(sorted.size());
+    id_values.reserve(sorted.size());
+    group_values.reserve(sorted.size());
+    category_values.reserve(sorted.size());
+    
+    for (const auto& point : sorted) {
+        x_values.push_back(point.x);
+        y_values.push_back(point.y);
+        id_values.push_back(point.id);
+        group_values.push_back(point.group_id);
+        category_values.push_back(point.category);
+    }
+    zones = ZoneMap(sorted);
+    sorted.clear();
+    sorted.shrink_to_fit();
+    
+    xs = packCoordinates(x_values);
+    ys = packCoordinates(y_values);
+    ids = PackedColumn(id_values);
+    group_ids = PackedColumn(group_values);
+    categories = PackedColumn(category_values);
+    
+    size_t rows = ids.size();
+    std::cout << "Compressed column store built: " << rows << " rows, " << memoryUsage() << " bytes ("
+              << (rows > 0 ? static_cast<double>(memoryUsage()) / rows : 0.0) << " per point)" << std::endl;
+}
+
+CompressedBackend::CoordinateColumn CompressedBackend::packCoordinates(const std::vector<double>& values) {
+    double powers[MAX_DIGITS + 1];
+    powers[0] = 1.0;
+    for (int d = 1; d <= MAX_DIGITS; ++d) {
+        powers[d] = powers[d - 1] * 10.0;
+    }
+    
+    // Fewest decimals covering every value that has an exact decimal code at all
+    int digits = 0;
+    int64_t code;
+    for (double value : values) {
+        for (int d = digits; d <= MAX_DIGITS; ++d) {
+            if (fixedCode(value, powers[d], code)) {
+                digits = d;
+                break;
+            }
+        }
+    }
+    
+    CoordinateColumn column;
+    column.scale = powers[digits];
+    
+    // A block is decimal only if every one of its values round-trips at that scale
+    std::vector<int64_t> codes(values.size());
+    size_t block_count = (values.size() + PackedColumn::BLOCK_SIZE - 1) / PackedColumn::BLOCK_SIZE;
+    column.fixed_point.assign(block_count, true);
+    for (size_t b = 0; b < block_count; ++b) {
+        size_t first = b * PackedColumn::BLOCK_SIZE;
+        size_t last = std::min(values.size(), first + PackedColumn::BLOCK_SIZE);
+        for (size_t i = first; i < last && column.fixed_point[b]; ++i) {
+            column.fixed_point[b] = fixedCode(values[i], column.scale, codes[i]);
+        }
+        if (!column.fixed_point[b]) {
+            for (size_t i = first; i < last; ++i) {
+                codes[i] = bitsCode(values[i]);
+            }
+        }
+    }
+    
+    // At least 16 bits, the narrowest the scan kernels take
+    column.codes = PackedColumn(codes, 2);
+    return column;
+}
+
+Point CompressedBackend::row(size_t i) const {
+    return Point(xs.decode(i), ys.decode(i), ids.at(i), group_ids.at(i), static_cast<int>(categories.at(i)));
+}
+
+size_t CompressedBackend::firstRowAfter(const KeysetCursor& after) const {
+    // Rows are in (y, x, id) order: binary search on the decoded key
+    size_t low = 0, high = size();
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        double y = ys.decode(mid);
+        bool before_or_at = y < after.y;
+        if (y == after.y) {
+            double x = xs.decode(mid);
+            before_or_at = x < after.x || (x == after.x && ids.at(mid) <= after.id);
+        }
+        if (before_or_at) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+size_t CompressedBackend::memoryUsage() const {
+    return xs.codes.memoryUsage() + ys.codes.memoryUsage() + (xs.fixed_point.size() + ys.fixed_point.size()) / 8 +
+           ids.memoryUsage() + group_ids.memoryUsage() + categories.memoryUsage() + zones.memoryUsage();
+}
+
+void CompressedBackend::planSearch(const Rectangle& crop, const CropFilter& filter, std::vector<SearchRange>& ranges) const {
+    // The band of rows with crop.min_y <= y <= crop.max_y
+    auto first_where = [this](size_t low, auto condition) {
+        size_t high = size();
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            if (condition(ys.decode(mid))) {
+                high = mid;
+            } else {
+                low = mid + 1;
+            }
+        }
+        return low;
+    };
+    size_t first = first_where(0, [&](double y) { return y >= crop.p_min.y; });
+    size_t last = first_where(first, [&](double y) { return y > crop.p_max.y; });
+    
+    if (filter.after.has_value()) {
+        first = std::max(first, firstRowAfter(filter.after.value()));
+    }
+    if (first < last) {
+        ranges.push_back({first, last, 0});
+    }
+}
+
+void CompressedBackend::scanRanges(const Rectangle& crop, const CropFilter& filter, const std::vector<SearchRange>& ranges,
+                                   std::vector<Point>& out, size_t max_results) const {
+    uint64_t mask[PackedColumn::BLOCK_SIZE / 64];
+    ZoneMap::Probe probe(zones, crop, filter);
+    
+    filter.dispatch([&](const auto& accepts) {
+        for (const auto& range : ranges) {
+            for (size_t first = range.first; first < range.last && out.size() < max_results;) {
+                // One block (or the part of it inside the range) at a time
+                size_t block_end = (first / PackedColumn::BLOCK_SIZE + 1) * PackedColumn::BLOCK_SIZE;
+                size_t count = std::min(range.last, block_end) - first;
+                
+                ZoneMap::Overlap overlap = probe.test(first);
+                if (overlap == ZoneMap::Overlap::NONE) {
+                    first += count;
+                    continue;
+                }
+                ScanKernel::selectAll(count, mask);
+                if (overlap == ZoneMap::Overlap::PARTIAL) {
+                    ys.andRangeMask(first, count, crop.p_min.y, crop.p_max.y, mask);
+                    xs.andRangeMask(first, count, crop.p_min.x, crop.p_max.x, mask);
+                }
+                
+                // Only rows inside the rectangle are decoded
+                for (size_t w = 0; w < ScanKernel::maskWords(count); ++w) {
+                    for (uint64_t bits = mask[w]; bits != 0; bits &= bits - 1) {
+                        Point point = row(first + w * 64 + static_cast<size_t>(__builtin_ctzll(bits)));
+                        if (accepts(point)) {
+                            out.push_back(point);
+                            if (out.size() >= max_results) {
+                                return;
+                            }
+                        }
+                    }
+                }
+                first += count;
+            }
+        }
+    });
+}
\ No newline at end of file
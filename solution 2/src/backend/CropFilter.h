@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <optional>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+#include "../geometry/CategoryMask.h"
+#include "../geometry/Point.h"
+
+/**
+ * Per-query point predicate shared by the in-memory backends and the brute force scan
+ *
+ * Holds everything except the crop rectangle, which the index itself handles:
+ * category and group filters and the proper constraint resolved to a group set.
+ * The keyset cursor is carried along for backends that can seek to it; the
+ * predicate itself does not test it (callers drop the rows up to the cursor).
+ */
+struct CropFilter {
+    CategoryMask categories;                    // Empty = any category
+    std::unordered_set<long long> groups;       // Empty and !restrict_groups = any group
+    bool restrict_groups = false;               // Group filter given (possibly intersected with proper set)
+    std::unordered_set<long long> excluded;     // Groups to drop (proper: false)
+    std::optional<KeysetCursor> after;
+    std::vector<long long> sorted_groups;       // groups ascending, for zone map probes (see sortGroups)
+    
+    /**
+     * Fill sorted_groups from groups; call once after the group set is final, before any ZoneMap::Probe is built
+     */
+    void sortGroups() {
+        sorted_groups.assign(groups.begin(), groups.end());
+        std::sort(sorted_groups.begin(), sorted_groups.end());
+    }
+    
+    /**
+     * Check every condition except the crop rectangle, deciding at run time which ones apply
+     */
+    bool accepts(const Point& point) const;
+    
+    /**
+     * Call visit once with the FilterPipeline specialized for the conditions this query uses
+     *
+     * Choosing the variant once per query keeps the per-point loop free of
+     * "is this filter set?" branches; visit is typically a generic lambda that
+     * runs the whole scan with the pipeline it is given.
+     * @tparam CheckCategory false when the caller has already applied the category filter
+     * @param visit Callable taking any FilterPipeline<...> by const reference
+     */
+    template <bool CheckCategory = true, typename Visitor>
+    void dispatch(Visitor&& visit) const;
+};
+
+/**
+ * CropFilter with the set of active conditions fixed at compile time
+ *
+ * There are eight variants (category x group set x excluded set); the group
+ * set covers both the group filter and proper: true, the excluded set is
+ * proper: false. Conditions switched off compile to nothing.
+ */
+template <bool ByCategory, bool ByGroup, bool Excluding>
+struct FilterPipeline {
+    const CropFilter* filter;
+    
+    bool operator()(const Point& point) const {
+        if constexpr (ByCategory) {
+            if (!filter->categories.contains(point.category)) return false;
+        }
+        if constexpr (ByGroup) {
+            if (filter->groups.count(point.group_id) == 0) return false;
+        }
+        if constexpr (Excluding) {
+            if (filter->excluded.count(point.group_id) > 0) return false;
+        }
+        return true;
+    }
+};
+
+inline bool CropFilter::accepts(const Point& point) const {
+    if (!categories.empty() && !categories.contains(point.category)) return false;
+    if (restrict_groups && groups.count(point.group_id) == 0) return false;
+    if (!excluded.empty() && excluded.count(point.group_id) > 0) return false;
+    return true;
+}
+
+template <bool CheckCategory, typename Visitor>
+void CropFilter::dispatch(Visitor&& visit) const {
+    auto with_groups = [&](auto by_category) {
+        constexpr bool C = decltype(by_category)::value;
+        if (restrict_groups) {
+            if (!excluded.empty()) visit(FilterPipeline<C, true, true>{this});
+            else visit(FilterPipeline<C, true, false>{this});
+        } else {
+            if (!excluded.empty()) visit(FilterPipeline<C, false, true>{this});
+            else visit(FilterPipeline<C, false, false>{this});
+        }
+    };
+    
+    if (CheckCategory && !categories.empty()) {
+        with_groups(std::true_type{});
+    } else {
+        with_groups(std::false_type{});
+    }
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#include "DatabaseBackend.h"
+
+std::vector<Point> DatabaseBackend::executeCrop(const CropRequest& request) {
+    return db_manager.executeCropQuery(
+        request.crop_region,
+        request.valid_region,
+        request.category_filter,
+        request.group_filter,
+        request.proper_constraint,
+        request.limit,
+        request.after
+    );
+}
+
+AggregateResult DatabaseBackend::executeAggregate(const CropRequest& request, OutputMode mode) {
+    return db_manager.executeAggregateQuery(
+        request.crop_region,
+        request.valid_region,
+        mode,
+        request.category_filter,
+        request.group_filter,
+        request.proper_constraint
+    );
+}
\ No newline at end of file
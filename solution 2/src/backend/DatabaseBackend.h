@@ -0,0 +1,29 @@
+#pragma once
+
+#include "QueryBackend.h"
+#include "../database/DatabaseManager.h"
+
+/**
+ * Backend that runs every crop as SQL on a single PostgreSQL instance
+ */
+class DatabaseBackend : public QueryBackend {
+private:
+    DatabaseManager& db_manager;
+
+public:
+    /**
+     * @param manager Database manager to query (must outlive the backend)
+     */
+    explicit DatabaseBackend(DatabaseManager& manager) : db_manager(manager) {}
+    
+    std::string getName() const override { return "database"; }
+    
+    std::vector<Point> executeCrop(const CropRequest& request) override;
+    
+    /**
+     * Aggregates are pushed down into SQL, so no rows are transferred
+     */
+    AggregateResult executeAggregate(const CropRequest& request, OutputMode mode) override;
+    
+    bool testConnection() override { return db_manager.testConnection(); }
+};
\ No newline at end of file
@@ -0,0 +1,215 @@
+#include "GridBackend.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint32_t EMPTY_CELL = std::numeric_limits<uint32_t>::max();
+
+// Identical coordinates cannot be separated; stop splitting at this depth
+constexpr int MAX_DEPTH = 24;
+
+}
+
+GridBackend::GridBackend(const std::vector<Point>& all_points, size_t target_cell_points, size_t capacity)
+    : InMemoryBackend(all_points), leaf_capacity(std::max<size_t>(1, capacity)), points(all_points) {
+    if (points.size() >= EMPTY_CELL) {
+        throw std::runtime_error("Grid index supports fewer than 2^32 points");
+    }
+    if (points.empty()) {
+        cells.assign(1, EMPTY_CELL);
+        return;
+    }
+    
+    // Data bounds and a grid with about target_cell_points points per cell, cells roughly square
+    min_x = max_x = points[0].x;
+    min_y = max_y = points[0].y;
+    for (const auto& point : points) {
+        min_x = std::min(min_x, point.x);
+        max_x = std::max(max_x, point.x);
+        min_y = std::min(min_y, point.y);
+        max_y = std::max(max_y, point.y);
+    }
+    
+    double total_cells = std::max(1.0, static_cast<double>(points.size()) / std::max<size_t>(1, target_cell_points));
+    double width = std::max(max_x - min_x, std::numeric_limits<double>::min());
+    double height = std::max(max_y - min_y, std::numeric_limits<double>::min());
+    double aspect = std::clamp(width / height, 1.0 / total_cells, total_cells);
+    cells_x = std::clamp<size_t>(static_cast<size_t>(std::sqrt(total_cells * aspect)), 1, 1 << 16);
+    cells_y = std::clamp<size_t>(static_cast<size_t>(total_cells / cells_x), 1, 1 << 16);
+    
+    // Counting sort of the points into cells
+    std::vector<size_t> cell_of(points.size());
+    std::vector<size_t> cell_start(cells_x * cells_y + 1, 0);
+    for (size_t i = 0; i < points.size(); ++i) {
+        cell_of[i] = cellY(points[i].y) * cells_x + cellX(points[i].x);
+        ++cell_start[cell_of[i] + 1];
+    }
+    for (size_t c = 1; c < cell_start.size(); ++c) {
+        cell_start[c] += cell_start[c - 1];
+    }
+    
+    std::vector<Point> by_cell(points.size());
+    std::vector<size_t> next = cell_start;
+    for (size_t i = 0; i < points.size(); ++i) {
+        by_cell[next[cell_of[i]]++] = points[i];
+    }
+    points = std::move(by_cell);
+    
+    // One node per non-empty cell, refined while overloaded
+    cells.assign(cells_x * cells_y, EMPTY_CELL);
+    double cell_width = (max_x - min_x) / cells_x;
+    double cell_height = (max_y - min_y) / cells_y;
+    
+    for (size_t cy = 0; cy < cells_y; ++cy) {
+        for (size_t cx = 0; cx < cells_x; ++cx) {
+            size_t c = cy * cells_x + cx;
+            size_t count = cell_start[c + 1] - cell_start[c];
+            if (count == 0) continue;
+            
+            Rectangle region(min_x + cx * cell_width, min_y + cy * cell_height,
+                             min_x + (cx + 1) * cell_width, min_y + (cy + 1) * cell_height);
+            cells[c] = static_cast<uint32_t>(nodes.size());
+            nodes.emplace_back();
+            buildNode(cells[c], cell_start[c], count, region, 0);
+        }
+    }
+    
+    std::cout << "Grid built: " << cells_x << "x" << cells_y << " cells, " << nodes.size() << " nodes" << std::endl;
+}
+
+size_t GridBackend::cellX(double x) const {
+    if (max_x <= min_x) return 0;
+    double position = (x - min_x) / (max_x - min_x) * cells_x;
+    return static_cast<size_t>(std::clamp(position, 0.0, static_cast<double>(cells_x - 1)));
+}
+
+size_t GridBackend::cellY(double y) const {
+    if (max_y <= min_y) return 0;
+    double position = (y - min_y) / (max_y - min_y) * cells_y;
+    return static_cast<size_t>(std::clamp(position, 0.0, static_cast<double>(cells_y - 1)));
+}
+
+void GridBackend::buildNode(uint32_t index, size_t first, size_t count, const Rectangle& region, int depth) {
+    auto begin = points.begin() + first;
+    auto end = begin + count;
+    
+    Node node{0, 0, 0, 0, static_cast<uint32_t>(first), static_cast<uint32_t>(count), 0};
+    if (count == 0) {
+        nodes[index] = node;
+        return;
+    }
+    
+    node.min_x = node.max_x = begin->x;
+    node.min_y = node.max_y = begin->y;
+    for (auto it = begin; it != end; ++it) {
+        node.min_x = std::min(node.min_x, it->x);
+        node.min_y = std::min(node.min_y, it->y);
+        node.max_x = std::max(node.max_x, it->x);
+        node.max_y = std::max(node.max_y, it->y);
+    }
+    
+    bool degenerate = node.min_x == node.max_x && node.min_y == node.max_y;
+    if (count <= leaf_capacity || depth >= MAX_DEPTH || degenerate) {
+        std::sort(begin, end);
+        nodes[index] = node;
+        return;
+    }
+    
+    // Split at the region's center: bottom-left, bottom-right, top-left, top-right
+    double mid_x = (region.p_min.x + region.p_max.x) / 2;
+    double mid_y = (region.p_min.y + region.p_max.y) / 2;
+    auto top = std::partition(begin, end, [mid_y](const Point& p) { return p.y < mid_y; });
+    auto bottom_right = std::partition(begin, top, [mid_x](const Point& p) { return p.x < mid_x; });
+    auto top_right = std::partition(top, end, [mid_x](const Point& p) { return p.x < mid_x; });
+    
+    const Rectangle quadrants[4] = {
+        Rectangle(region.p_min.x, region.p_min.y, mid_x, mid_y),
+        Rectangle(mid_x, region.p_min.y, region.p_max.x, mid_y),
+        Rectangle(region.p_min.x, mid_y, mid_x, region.p_max.y),
+        Rectangle(mid_x, mid_y, region.p_max.x, region.p_max.y)
+    };
+    const std::vector<Point>::iterator runs[5] = {begin, bottom_right, top, top_right, end};
+    
+    // Children occupy four consecutive slots
+    node.children = static_cast<uint32_t>(nodes.size());
+    nodes[index] = node;
+    nodes.resize(nodes.size() + 4);
+    
+    for (uint32_t q = 0; q < 4; ++q) {
+        buildNode(node.children + q, runs[q] - points.begin(), runs[q + 1] - runs[q], quadrants[q], depth + 1);
+    }
+}
+
+size_t GridBackend::memoryUsage() const {
+    return points.capacity() * sizeof(Point) + nodes.capacity() * sizeof(Node) +
+           cells.capacity() * sizeof(uint32_t);
+}
+
+void GridBackend::planSearch(const Rectangle& crop, const CropFilter& /*filter*/, std::vector<SearchRange>& ranges) const {
+    if (points.empty()) {
+        return;
+    }
+    
+    // Mapping is monotone, so every point in the crop lies in this cell range
+    size_t first_x = cellX(crop.p_min.x), last_x = cellX(crop.p_max.x);
+    size_t first_y = cellY(crop.p_min.y), last_y = cellY(crop.p_max.y);
+    
+    for (size_t cy = first_y; cy <= last_y; ++cy) {
+        for (size_t cx = first_x; cx <= last_x; ++cx) {
+            uint32_t node = cells[cy * cells_x + cx];
+            if (node != EMPTY_CELL) {
+                planNode(node, crop, ranges);
+            }
+        }
+    }
+}
+
+void GridBackend::planNode(uint32_t index, const Rectangle& crop, std::vector<SearchRange>& ranges) const {
+    const Node& node = nodes[index];
+    if (node.count == 0 ||
+        node.max_x < crop.p_min.x || node.min_x > crop.p_max.x ||
+        node.max_y < crop.p_min.y || node.min_y > crop.p_max.y) {
+        return;
+    }
+    
+    if (node.children != 0) {
+        for (uint32_t q = 0; q < 4; ++q) {
+            planNode(node.children + q, crop, ranges);
+        }
+        return;
+    }
+    
+    // Leaf: points are sorted by y, so only the crop's y range is visited
+    auto begin = points.begin() + node.first;
+    auto end = begin + node.count;
+    auto first = std::lower_bound(begin, end, crop.p_min.y,
+                                  [](const Point& p, double y) { return p.y < y; });
+    auto last = std::upper_bound(first, end, crop.p_max.y,
+                                 [](double y, const Point& p) { return y < p.y; });
+    
+    // Tag 1 marks leaves whose x range lies inside the crop
+    bool inside_x = node.min_x >= crop.p_min.x && node.max_x <= crop.p_max.x;
+    if (first != last) {
+        ranges.push_back({static_cast<size_t>(first - points.begin()), static_cast<size_t>(last - points.begin()),
+                          inside_x ? 1u : 0u});
+    }
+}
+
+void GridBackend::scanRanges(const Rectangle& crop, const CropFilter& filter, const std::vector<SearchRange>& ranges,
+                             std::vector<Point>& out, size_t /*max_results*/) const {
+    filter.dispatch([&](const auto& accepts) {
+        for (const auto& range : ranges) {
+            bool inside_x = range.tag != 0;
+            for (size_t i = range.first; i < range.last; ++i) {
+                const Point& point = points[i];
+                if ((inside_x || (point.x >= crop.p_min.x && point.x <= crop.p_max.x)) && accepts(point)) {
+                    out.push_back(point);
+                }
+            }
+        }
+    });
+}
\ No newline at end of file
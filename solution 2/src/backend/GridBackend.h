@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "InMemoryBackend.h"
+
+/**
+ * In-memory uniform grid whose overloaded cells are refined into quadtrees
+ *
+ * The grid covers the data bounds with about one cell per target_cell_points
+ * points. Clustered data leaves some cells far over that, so any cell (or
+ * quadrant) holding more than leaf_capacity points is split into four
+ * quadrants until it fits. Each leaf is a contiguous run of one point array,
+ * sorted by (y, x, id), so a crop binary-searches the leaf's y range and only
+ * visits the leaves that overlap the rectangle.
+ */
+class GridBackend : public InMemoryBackend {
+private:
+    struct Node {
+        double min_x = 0, min_y = 0, max_x = 0, max_y = 0;  // Tight bounding box of the node's points
+        uint32_t first = 0;     // First point of the node's run
+        uint32_t count = 0;     // Points in the run
+        uint32_t children = 0;  // Index of the first of 4 children; 0 for leaves
+    };
+    
+    size_t leaf_capacity;
+    double min_x = 0.0, min_y = 0.0, max_x = 0.0, max_y = 0.0;
+    size_t cells_x = 1, cells_y = 1;
+    std::vector<Point> points;     // Grouped by leaf
+    std::vector<Node> nodes;       // Node of every non-empty cell, then quadtree children
+    std::vector<uint32_t> cells;   // Node index per cell (row-major), UINT32_MAX when empty
+
+public:
+    /**
+     * Build the grid and refine overloaded cells
+     * @param all_points Snapshot of all points
+     * @param target_cell_points Average points per grid cell to size the grid
+     * @param capacity Maximum points per leaf before it is split
+     */
+    explicit GridBackend(const std::vector<Point>& all_points, size_t target_cell_points = 64, size_t capacity = 256);
+    
+    std::string getName() const override { return "grid"; }
+    
+    size_t memoryUsage() const override;
+    
+    size_t size() const override { return points.size(); }
+
+protected:
+    void planSearch(const Rectangle& crop, const CropFilter& filter, std::vector<SearchRange>& ranges) const override;
+    
+    void scanRanges(const Rectangle& crop, const CropFilter& filter, const std::vector<SearchRange>& ranges,
+                    std::vector<Point>& out, size_t max_results) const override;
+
+private:
+    size_t cellX(double x) const;
+    size_t cellY(double y) const;
+    
+    /**
+     * Fill the node for points[first, first + count) and split it while overloaded
+     * @param index Slot of the node (already allocated)
+     * @param first First point of the run
+     * @param count Points in the run
+     * @param region Area the run was assigned to (split at its center)
+     * @param depth Quadtree depth below the grid cell
+     */
+    void buildNode(uint32_t index, size_t first, size_t count, const Rectangle& region, int depth);
+    
+    /**
+     * Append the leaf runs below a node that can hold points inside crop
+     */
+    void planNode(uint32_t index, const Rectangle& crop, std::vector<SearchRange>& ranges) const;
+};
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include "InMemoryBackend.h"
+#include "ColumnarBackend.h"
+#include "CompressedBackend.h"
+#include "GridBackend.h"
+#include "LearnedBackend.h"
+#include "RangeTreeBackend.h"
+#include "RTreeBackend.h"
+#include "MorselScheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+namespace {
+
+/**
+ * Remove the rows up to and including the cursor from sorted points
+ */
+void dropThroughCursor(std::vector<Point>& points, const std::optional<KeysetCursor>& after) {
+    if (after.has_value()) {
+        points.erase(points.begin(), std::partition_point(points.begin(), points.end(),
+                                                          [&](const Point& p) { return !after->precedes(p); }));
+    }
+}
+
+} // namespace
+
+InMemoryBackend::InMemoryBackend(const std::vector<Point>& points) {
+    for (const auto& point : points) {
+        auto it = group_bounds.find(point.group_id);
+        if (it == group_bounds.end()) {
+            group_bounds.emplace(point.group_id, Rectangle(point.x, point.y, point.x, point.y));
+        } else {
+            Rectangle& bounds = it->second;
+            bounds.p_min.x = std::min(bounds.p_min.x, point.x);
+            bounds.p_min.y = std::min(bounds.p_min.y, point.y);
+            bounds.p_max.x = std::max(bounds.p_max.x, point.x);
+            bounds.p_max.y = std::max(bounds.p_max.y, point.y);
+        }
+    }
+}
+
+CropFilter InMemoryBackend::makeFilter(const CropRequest& request) const {
+    CropFilter filter;
+    filter.categories = request.category_filter;
+    filter.after = request.after;
+    
+    if (!request.group_filter.empty()) {
+        filter.restrict_groups = true;
+        filter.groups.insert(request.group_filter.begin(), request.group_filter.end());
+    }
+    
+    if (request.proper_constraint.has_value()) {
+        // A group is proper if its bounding box lies inside the valid region
+        std::unordered_set<long long> proper_groups;
+        for (const auto& [group_id, bounds] : group_bounds) {
+            if (request.valid_region.contains(bounds.p_min) && request.valid_region.contains(bounds.p_max)) {
+                proper_groups.insert(group_id);
+            }
+        }
+        
+        if (request.proper_constraint.value()) {
+            // Keep only proper groups (within the group filter, if any)
+            if (filter.restrict_groups) {
+                for (auto it = filter.groups.begin(); it != filter.groups.end();) {
+                    it = proper_groups.count(*it) > 0 ? std::next(it) : filter.groups.erase(it);
+                }
+            } else {
+                filter.groups = std::move(proper_groups);
+                filter.restrict_groups = true;
+            }
+        } else {
+            filter.excluded = std::move(proper_groups);
+        }
+    }
+    
+    // Sorted once here rather than by every zone map probe (one per scanned morsel)
+    filter.sortGroups();
+    return filter;
+}
+
+std::vector<Point> InMemoryBackend::executeCrop(const CropRequest& request) {
+    std::vector<Point> result;
+    
+    CropFilter filter = makeFilter(request);
+    if (filter.restrict_groups && filter.groups.empty()) {
+        return result;
+    }
+    
+    // Nothing before the cursor's row can qualify
+    Rectangle crop = request.crop_region;
+    if (request.after.has_value()) {
+        crop.p_min.y = std::max(crop.p_min.y, request.after->y);
+    }
+    if (!crop.isValid()) {
+        return result;
+    }
+    
+    size_t max_results = request.limit.value_or(std::numeric_limits<size_t>::max());
+    
+    std::vector<SearchRange> ranges;
+    planSearch(crop, filter, ranges);
+    size_t candidates = 0;
+    for (const auto& range : ranges) {
+        candidates += range.last - range.first;
+    }
+    
+    if (candidates >= MorselScheduler::PARALLEL_THRESHOLD && MorselScheduler::shared().getThreadCount() > 1) {
+        return scanParallel(crop, filter, ranges, max_results);
+    }
+    
+    scanRanges(crop, filter, ranges, result, max_results);
+    if (!searchIsSorted()) {
+        std::sort(result.begin(), result.end());
+    }
+    dropThroughCursor(result, request.after);
+    if (result.size() > max_results) {
+        result.resize(max_results);
+    }
+    
+    return result;
+}
+
+std::vector<Point> InMemoryBackend::scanParallel(const Rectangle& crop, const CropFilter& filter,
+                                                 const std::vector<SearchRange>& ranges, size_t max_results) const {
+    // Cut the runs into morsels of MORSEL_SIZE positions (the last one may be short)
+    std::vector<std::vector<SearchRange>> morsels(1);
+    size_t filled = 0;
+    for (SearchRange range : ranges) {
+        while (range.first < range.last) {
+            size_t take = std::min(range.last - range.first, MorselScheduler::MORSEL_SIZE - filled);
+            morsels.back().push_back({range.first, range.first + take, range.tag});
+            range.first += take;
+            filled += take;
+            if (filled == MorselScheduler::MORSEL_SIZE) {
+                morsels.emplace_back();
+                filled = 0;
+            }
+        }
+    }
+    if (morsels.back().empty()) {
+        morsels.pop_back();
+    }
+    
+    bool sorted = searchIsSorted();
+    std::vector<std::vector<Point>> buffers(morsels.size());
+    std::atomic<size_t> first_full(std::numeric_limits<size_t>::max());  // Sorted: first morsel that fills the page alone
+    
+    MorselScheduler::shared().parallelFor(morsels.size(), [&](size_t m) {
+        // With sorted output, nothing after a morsel that already holds a full page can be returned
+        if (sorted && m > first_full.load(std::memory_order_relaxed)) {
+            return;
+        }
+        
+        std::vector<Point>& buffer = buffers[m];
+        scanRanges(crop, filter, morsels[m], buffer, max_results);
+        
+        if (sorted) {
+            size_t current = first_full.load();
+            while (buffer.size() >= max_results && m < current) {
+                if (first_full.compare_exchange_weak(current, m)) {
+                    break;
+                }
+            }
+        } else {
+            std::sort(buffer.begin(), buffer.end());
+            dropThroughCursor(buffer, filter.after);
+            if (buffer.size() > max_results) {
+                buffer.resize(max_results);
+            }
+        }
+    });
+    
+    if (!sorted) {
+        return mergeSortedPoints(buffers, max_results);
+    }
+    
+    // Morsels follow the plan order, so their buffers concatenate into sorted output
+    std::vector<Point> result;
+    for (const auto& buffer : buffers) {
+        if (result.size() >= max_results) {
+            break;
+        }
+        size_t take = std::min(buffer.size(), max_results - result.size());
+        result.insert(result.end(), buffer.begin(), buffer.begin() + take);
+    }
+    return result;
+}
+
+std::vector<std::string> inMemoryBackendNames() {
+    return {"rtree", "columnar", "compressed", "grid", "rangetree", "learned", "learned_morton"};
+}
+
+std::unique_ptr<InMemoryBackend> createInMemoryBackend(const std::string& name, const std::vector<Point>& points) {
+    if (name == "rtree") {
+        return std::make_unique<RTreeBackend>(points);
+    }
+    if (name == "columnar") {
+        return std::make_unique<ColumnarBackend>(points);
+    }
+    if (name == "compressed") {
+        return std::make_unique<CompressedBackend>(points);
+    }
+    if (name == "grid") {
+        return std::make_unique<GridBackend>(points);
+    }
+    if (name == "rangetree") {
+        return std::make_unique<RangeTreeBackend>(points);
+    }
+    if (name == "learned") {
+        return std::make_unique<LearnedBackend>(points, CurveType::Hilbert);
+    }
+    if (name == "learned_morton") {
+        return std::make_unique<LearnedBackend>(points, CurveType::Morton);
+    }
+    throw std::runtime_error("Unknown backend: " + name);
+}
\ No newline at end of file
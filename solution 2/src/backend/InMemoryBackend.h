@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "CropFilter.h"
+#include "QueryBackend.h"
+
+/**
+ * Contiguous run of positions in one of a backend's arrays that a crop has to filter
+ *
+ * What the positions index and what the tag means is up to the backend. Runs
+ * can be split at any position, which is how a large scan is cut into morsels.
+ */
+struct SearchRange {
+    size_t first;
+    size_t last;        // Exclusive
+    uint32_t tag;
+};
+
+/**
+ * Base class for backends that keep all points in memory
+ *
+ * The point set is a snapshot taken when the backend is built (normally
+ * DatabaseManager::getAllPoints); later database changes are not seen. Subclasses
+ * only implement the spatial search; the filters, the proper constraint, the
+ * (y, x, id) order and the keyset window are handled here. Built indexes are
+ * immutable, so concurrent queries are safe. Crops with many candidates are
+ * scanned in parallel, morsel by morsel, on MorselScheduler::shared().
+ */
+class InMemoryBackend : public QueryBackend {
+private:
+    std::unordered_map<long long, Rectangle> group_bounds;  // Bounding box of every group
+
+public:
+    std::vector<Point> executeCrop(const CropRequest& request) override;
+    
+    /**
+     * Number of indexed points
+     */
+    virtual size_t size() const = 0;
+    
+    /**
+     * Approximate heap memory held by the index, in bytes (excluding the group bounds)
+     */
+    virtual size_t memoryUsage() const = 0;
+
+protected:
+    /**
+     * @param points Snapshot of all points (used for the group bounds)
+     */
+    explicit InMemoryBackend(const std::vector<Point>& points);
+    
+    /**
+     * Collect the runs of positions that can hold points inside crop
+     * @param crop Crop rectangle (already narrowed to the cursor's y)
+     * @param filter Remaining conditions (backends that can seek to the cursor use filter.after)
+     * @param ranges Destination; in output order when searchIsSorted()
+     */
+    virtual void planSearch(const Rectangle& crop, const CropFilter& filter, std::vector<SearchRange>& ranges) const = 0;
+    
+    /**
+     * Append the points of the given runs that lie inside crop and pass the filter
+     * @param crop Crop rectangle
+     * @param filter Remaining conditions (subclasses run their scan with filter.dispatch)
+     * @param ranges Runs from planSearch, possibly split
+     * @param out Destination, may include rows up to the cursor
+     * @param max_results Backends whose output is sorted may stop after this many points
+     */
+    virtual void scanRanges(const Rectangle& crop, const CropFilter& filter, const std::vector<SearchRange>& ranges,
+                            std::vector<Point>& out, size_t max_results) const = 0;
+    
+    /**
+     * Whether scanRanges() appends points already in (y, x, id) order when given runs in plan order
+     */
+    virtual bool searchIsSorted() const { return false; }
+
+private:
+    /**
+     * Resolve the request's group filter and proper constraint into a filter
+     */
+    CropFilter makeFilter(const CropRequest& request) const;
+    
+    /**
+     * Scan the runs morsel by morsel on the shared scheduler
+     * Each morsel fills its own buffer; sorted buffers are stitched in morsel
+     * order, the others sorted by their worker and merged.
+     * @return Matching points after the cursor in (y, x, id) order, at most max_results
+     */
+    std::vector<Point> scanParallel(const Rectangle& crop, const CropFilter& filter,
+                                    const std::vector<SearchRange>& ranges, size_t max_results) const;
+};
+
+/**
+ * Names accepted by createInMemoryBackend
+ */
+std::vector<std::string> inMemoryBackendNames();
+
+/**
+ * Build an in-memory backend by name
+ * @param name Backend name (see inMemoryBackendNames)
+ * @param points Snapshot of all points
+ * @throws std::runtime_error on unknown names
+ */
+std::unique_ptr<InMemoryBackend> createInMemoryBackend(const std::string& name, const std::vector<Point>& points);
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "LearnedBackend.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+Rectangle boundsOf(const std::vector<Point>& points) {
+    if (points.empty()) {
+        return Rectangle(0.0, 0.0, 1.0, 1.0);
+    }
+    Rectangle bounds(points[0].x, points[0].y, points[0].x, points[0].y);
+    for (const auto& point : points) {
+        bounds.p_min.x = std::min(bounds.p_min.x, point.x);
+        bounds.p_min.y = std::min(bounds.p_min.y, point.y);
+        bounds.p_max.x = std::max(bounds.p_max.x, point.x);
+        bounds.p_max.y = std::max(bounds.p_max.y, point.y);
+    }
+    return bounds;
+}
+
+}
+
+LearnedBackend::LearnedBackend(const std::vector<Point>& all_points, CurveType type, size_t error, size_t ranges)
+    : InMemoryBackend(all_points), curve(type, boundsOf(all_points)), max_error(std::max<size_t>(1, error)),
+      max_ranges(std::max<size_t>(1, ranges)) {
+    // Sort by key; (y, x, id) inside a key keeps the order deterministic
+    std::vector<std::pair<uint64_t, Point>> keyed;
+    keyed.reserve(all_points.size());
+    for (const auto& point : all_points) {
+        keyed.emplace_back(curve.encode(point), point);
+    }
+    std::sort(keyed.begin(), keyed.end(), [](const auto& a, const auto& b) {
+        if (a.first != b.first) return a.first < b.first;
+        return a.second < b.second;
+    });
+    
+    points.reserve(keyed.size());
+    keys.reserve(keyed.size());
+    for (const auto& [key, point] : keyed) {
+        keys.push_back(key);
+        points.push_back(point);
+    }
+    
+    fitModel();
+    
+    std::cout << "Learned index built: " << points.size() << " points, " << segments.size()
+              << " segments (max error " << max_error << ")" << std::endl;
+}
+
+void LearnedBackend::fitModel() {
+    // Shrinking cone: extend the segment while some slope keeps every point within max_error
+    size_t i = 0;
+    while (i < keys.size()) {
+        Segment segment{keys[i], i, 0.0};
+        double slope_low = 0.0;
+        double slope_high = std::numeric_limits<double>::infinity();
+        
+        size_t j = i + 1;
+        for (; j < keys.size(); ++j) {
+            if (keys[j] == keys[j - 1]) continue;  // Only the first position of a key is predicted
+            
+            double dx = static_cast<double>(keys[j] - segment.first_key);
+            double dy = static_cast<double>(j - segment.first_position);
+            double low = std::max(slope_low, (dy - max_error) / dx);
+            double high = std::min(slope_high, (dy + max_error) / dx);
+            if (low > high) break;
+            
+            slope_low = low;
+            slope_high = high;
+        }
+        
+        segment.slope = std::isinf(slope_high) ? 0.0 : (slope_low + slope_high) / 2;
+        segments.push_back(segment);
+        i = j;
+    }
+}
+
+size_t LearnedBackend::lowerBound(uint64_t key) const {
+    if (segments.empty() || key <= keys.front()) {
+        return 0;
+    }
+    if (key > keys.back()) {
+        return keys.size();
+    }
+    
+    // Last segment starting at or before the key
+    auto segment = std::upper_bound(segments.begin(), segments.end(), key,
+                                    [](uint64_t k, const Segment& s) { return k < s.first_key; }) - 1;
+    
+    double predicted = segment->first_position + segment->slope * static_cast<double>(key - segment->first_key);
+    size_t position = static_cast<size_t>(std::clamp(predicted, 0.0, static_cast<double>(keys.size() - 1)));
+    
+    // The first occurrence of every stored key is within max_error of its prediction; keys
+    // between stored keys resolve to the next stored key's position, which is also bracketed
+    size_t low = position > max_error + 1 ? position - max_error - 1 : 0;
+    size_t high = std::min(keys.size(), position + max_error + 2);
+    
+    // Widen if the window misses (only possible for keys between segments)
+    while (low > 0 && keys[low] >= key) {
+        low = low > 2 * max_error ? low - 2 * max_error : 0;
+    }
+    while (high < keys.size() && keys[high - 1] < key) {
+        high = std::min(keys.size(), high + 2 * max_error);
+    }
+    
+    return std::lower_bound(keys.begin() + low, keys.begin() + high, key) - keys.begin();
+}
+
+size_t LearnedBackend::memoryUsage() const {
+    return points.capacity() * sizeof(Point) + keys.capacity() * sizeof(uint64_t) +
+           segments.capacity() * sizeof(Segment);
+}
+
+void LearnedBackend::planSearch(const Rectangle& crop, const CropFilter& /*filter*/, std::vector<SearchRange>& ranges) const {
+    if (points.empty()) {
+        return;
+    }
+    
+    for (const KeyRange& range : curve.decompose(crop, max_ranges)) {
+        size_t first = lowerBound(range.first);
+        size_t last = range.last == std::numeric_limits<uint64_t>::max() ? keys.size() : lowerBound(range.last + 1);
+        if (first < last) {
+            ranges.push_back({first, last, 0});
+        }
+    }
+}
+
+void LearnedBackend::scanRanges(const Rectangle& crop, const CropFilter& filter, const std::vector<SearchRange>& ranges,
+                                std::vector<Point>& out, size_t /*max_results*/) const {
+    filter.dispatch([&](const auto& accepts) {
+        for (const auto& range : ranges) {
+            for (size_t i = range.first; i < range.last; ++i) {
+                const Point& point = points[i];
+                if (crop.contains(point) && accepts(point)) {
+                    out.push_back(point);
+                }
+            }
+        }
+    });
+}
\ No newline at end of file
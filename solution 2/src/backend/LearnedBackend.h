@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "InMemoryBackend.h"
+#include "../geometry/SpaceFillingCurve.h"
+
+/**
+ * In-memory learned index over space-filling-curve order
+ *
+ * Points are sorted by their curve key. A piecewise-linear model, fitted in
+ * one pass with the shrinking-cone method, maps a key to its position in that
+ * order to within +-max_error; a lookup is a binary search over the few segment
+ * start keys, one multiply-add and a binary search over 2 * max_error + 1 keys.
+ * A crop is decomposed into curve key ranges, and each range is located through
+ * the model instead of a tree descent and scanned with an exact filter.
+ */
+class LearnedBackend : public InMemoryBackend {
+private:
+    struct Segment {
+        uint64_t first_key;  // Smallest key predicted by this segment
+        size_t first_position;
+        double slope;        // Positions per key
+    };
+    
+    SpaceFillingCurve curve;
+    size_t max_error;
+    size_t max_ranges;
+    std::vector<Point> points;     // Sorted by curve key, then (y, x, id)
+    std::vector<uint64_t> keys;    // Curve key of each point
+    std::vector<Segment> segments;
+
+public:
+    /**
+     * Sort the snapshot along the curve and fit the model
+     * @param all_points Snapshot of all points
+     * @param type Curve to order the points by
+     * @param error Maximum distance between predicted and actual position
+     * @param ranges Maximum key ranges per crop
+     */
+    LearnedBackend(const std::vector<Point>& all_points, CurveType type = CurveType::Hilbert,
+                   size_t error = 32, size_t ranges = 64);
+    
+    std::string getName() const override { return curve.getType() == CurveType::Hilbert ? "learned" : "learned_morton"; }
+    
+    size_t memoryUsage() const override;
+    
+    size_t size() const override { return points.size(); }
+    
+    /**
+     * Number of linear pieces in the model
+     */
+    size_t segmentCount() const { return segments.size(); }
+
+protected:
+    void planSearch(const Rectangle& crop, const CropFilter& filter, std::vector<SearchRange>& ranges) const override;
+    
+    void scanRanges(const Rectangle& crop, const CropFilter& filter, const std::vector<SearchRange>& ranges,
+                    std::vector<Point>& out, size_t max_results) const override;
+
+private:
+    /**
+     * Fit the segments over the first occurrence of every distinct key
+     */
+    void fitModel();
+    
+    /**
+     * Position of the first point whose key is >= key
+     */
+    size_t lowerBound(uint64_t key) const;
+};
\ No newline at end of file
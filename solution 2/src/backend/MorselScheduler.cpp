@@ -0,0 +1,145 @@
+#include "MorselScheduler.h"
+#include <algorithm>
+
+std::atomic<size_t> MorselScheduler::shared_thread_count{0};
+
+MorselScheduler::MorselScheduler(size_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    
+    for (size_t i = 1; i < thread_count; ++i) {
+        workers.emplace_back(&MorselScheduler::workerLoop, this);
+    }
+}
+
+MorselScheduler::~MorselScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+MorselScheduler& MorselScheduler::shared() {
+    static MorselScheduler scheduler(shared_thread_count.load());
+    return scheduler;
+}
+
+void MorselScheduler::setSharedThreadCount(size_t thread_count) {
+    shared_thread_count = thread_count;
+}
+
+void MorselScheduler::parallelFor(size_t morsel_count, const std::function<void(size_t)>& body) {
+    if (morsel_count == 0) {
+        return;
+    }
+    if (morsel_count == 1 || workers.empty()) {
+        for (size_t morsel = 0; morsel < morsel_count; ++morsel) {
+            body(morsel);
+        }
+        return;
+    }
+    
+    // Split the morsel numbers into one contiguous share per participant
+    auto job = std::make_shared<Job>();
+    job->body = &body;
+    job->participant_limit = std::min(morsel_count, getThreadCount());
+    job->shares = std::make_unique<Share[]>(job->participant_limit);
+    job->pending = morsel_count;
+    for (size_t p = 0; p < job->participant_limit; ++p) {
+        job->shares[p].next = morsel_count * p / job->participant_limit;
+        job->shares[p].end = morsel_count * (p + 1) / job->participant_limit;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(job);
+    }
+    wake.notify_all();
+    
+    participate(*job);
+    
+    // Other participants may still be finishing the morsels they took
+    {
+        std::unique_lock<std::mutex> lock(job->mutex);
+        job->done.wait(lock, [&]() { return job->pending.load() == 0; });
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = std::find(jobs.begin(), jobs.end(), job);
+        if (it != jobs.end()) {
+            jobs.erase(it);
+        }
+    }
+    
+    if (job->error) {
+        std::rethrow_exception(job->error);
+    }
+}
+
+void MorselScheduler::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    
+    while (true) {
+        wake.wait(lock, [&]() { return stopping || !jobs.empty(); });
+        if (stopping) {
+            return;
+        }
+        
+        // A loop with all its participants (or no morsels left) takes no more threads
+        std::shared_ptr<Job> job = jobs.front();
+        if (job->participants.load() >= job->participant_limit) {
+            jobs.pop_front();
+            continue;
+        }
+        
+        lock.unlock();
+        participate(*job);
+        lock.lock();
+    }
+}
+
+void MorselScheduler::participate(Job& job) {
+    size_t participant = job.participants.fetch_add(1);
+    if (participant >= job.participant_limit) {
+        return;
+    }
+    
+    size_t morsel;
+    while (takeMorsel(job, participant, morsel)) {
+        if (!job.failed.load(std::memory_order_relaxed)) {
+            try {
+                (*job.body)(morsel);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(job.mutex);
+                if (!job.error) {
+                    job.error = std::current_exception();
+                }
+                job.failed = true;
+            }
+        }
+        
+        if (job.pending.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            job.done.notify_all();
+        }
+    }
+}
+
+bool MorselScheduler::takeMorsel(Job& job, size_t participant, size_t& morsel) {
+    for (size_t i = 0; i < job.participant_limit; ++i) {
+        Share& share = job.shares[(participant + i) % job.participant_limit];
+        if (share.next.load(std::memory_order_relaxed) >= share.end) {
+            continue;
+        }
+        morsel = share.next.fetch_add(1);
+        if (morsel < share.end) {
+            return true;
+        }
+    }
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Work-stealing thread pool for morsel-driven scans
+ *
+ * A parallel loop hands out morsels, small fixed-size pieces of a scan such as
+ * a range of rows or a run of index leaves. Every participating thread owns a
+ * contiguous share of the morsel numbers and takes morsels from the front of
+ * it; once its share is empty it steals from the front of the others', so
+ * skewed morsels (dense clusters, partially covered leaves) balance out. The
+ * calling thread takes part as well, and several loops may run at once (each
+ * concurrent query submits its own).
+ */
+class MorselScheduler {
+public:
+    static constexpr size_t MORSEL_SIZE = 16384;            // Candidate rows per morsel
+    static constexpr size_t PARALLEL_THRESHOLD = 65536;     // Fewer candidates than this run on the calling thread
+    
+    /**
+     * Start the workers
+     * @param thread_count Threads per loop, including the caller (0 = hardware concurrency)
+     */
+    explicit MorselScheduler(size_t thread_count = 0);
+    
+    /**
+     * Stop and join the workers (loops still running must have returned)
+     */
+    ~MorselScheduler();
+    
+    MorselScheduler(const MorselScheduler&) = delete;
+    MorselScheduler& operator=(const MorselScheduler&) = delete;
+    
+    /**
+     * Threads that can work on one loop, including the caller
+     */
+    size_t getThreadCount() const { return workers.size() + 1; }
+    
+    /**
+     * Run body(morsel) for every morsel in [0, morsel_count) and wait for all of them
+     *
+     * Each morsel runs exactly once, on some thread; bodies must not depend on
+     * the order. Runs inline when there is a single morsel or a single thread.
+     * @param morsel_count Number of morsels
+     * @param body Work for one morsel
+     * @throws Rethrows the first exception thrown by a body (the remaining morsels are skipped)
+     */
+    void parallelFor(size_t morsel_count, const std::function<void(size_t)>& body);
+    
+    /**
+     * Process-wide scheduler used by the in-memory backends and the brute force scan, created on first use
+     */
+    static MorselScheduler& shared();
+    
+    /**
+     * Size of the shared scheduler; only has an effect before its first use
+     * @param thread_count Threads per loop, including the caller (0 = hardware concurrency)
+     */
+    static void setSharedThreadCount(size_t thread_count);
+    
+private:
+    /**
+     * Morsel numbers one participant starts with; alignas keeps the counters on separate cache lines
+     */
+    struct alignas(64) Share {
+        std::atomic<size_t> next{0};
+        size_t end = 0;
+    };
+    
+    /**
+     * One parallel loop
+     */
+    struct Job {
+        const std::function<void(size_t)>* body;
+        size_t participant_limit;
+        std::unique_ptr<Share[]> shares;
+        std::atomic<size_t> participants{0};
+        std::atomic<size_t> pending;            // Morsels not finished yet
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    
+    std::vector<std::thread> workers;
+    std::deque<std::shared_ptr<Job>> jobs;      // Loops that may still take participants
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    
+    static std::atomic<size_t> shared_thread_count;
+    
+    void workerLoop();
+    
+    /**
+     * Join a loop and run morsels until none are left to take
+     */
+    static void participate(Job& job);
+    
+    /**
+     * Claim the next morsel, from the participant's own share first, then by stealing
+     * @return false when every share is exhausted
+     */
+    static bool takeMorsel(Job& job, size_t participant, size_t& morsel);
+};
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "PackedColumn.h"
+#include <algorithm>
+
+namespace {
+
+template <typename T>
+void appendOffsets(std::vector<T>& data, const int64_t* values, size_t count, int64_t base) {
+    for (size_t i = 0; i < count; ++i) {
+        data.push_back(static_cast<T>(static_cast<uint64_t>(values[i]) - static_cast<uint64_t>(base)));
+    }
+}
+
+} // namespace
+
+PackedColumn::PackedColumn(const std::vector<int64_t>& values, uint8_t min_width) : rows(values.size()) {
+    blocks.reserve((rows + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    
+    for (size_t first = 0; first < rows; first += BLOCK_SIZE) {
+        size_t count = std::min(BLOCK_SIZE, rows - first);
+        const int64_t* block_values = values.data() + first;
+        auto [low, high] = std::minmax_element(block_values, block_values + count);
+        
+        // Unsigned difference, so even a block spanning the whole int64 range fits in 8 bytes
+        uint64_t range = static_cast<uint64_t>(*high) - static_cast<uint64_t>(*low);
+        uint8_t width = 8;
+        for (uint8_t candidate : {1, 2, 4}) {
+            if (candidate >= min_width && range < (uint64_t(1) << (8 * candidate))) {
+                width = candidate;
+                break;
+            }
+        }
+        
+        Block block{*low, 0, width};
+        switch (width) {
+            case 1:
+                block.offset = data8.size();
+                appendOffsets(data8, block_values, count, *low);
+                break;
+            case 2:
+                block.offset = data16.size();
+                appendOffsets(data16, block_values, count, *low);
+                break;
+            case 4:
+                block.offset = data32.size();
+                appendOffsets(data32, block_values, count, *low);
+                break;
+            default:
+                block.offset = data64.size();
+                appendOffsets(data64, block_values, count, *low);
+                break;
+        }
+        blocks.push_back(block);
+    }
+    
+    data8.shrink_to_fit();
+    data16.shrink_to_fit();
+    data32.shrink_to_fit();
+    data64.shrink_to_fit();
+}
+
+int64_t PackedColumn::at(size_t row) const {
+    const Block& b = blocks[row / BLOCK_SIZE];
+    size_t i = b.offset + row % BLOCK_SIZE;
+    
+    uint64_t offset;
+    switch (b.width) {
+        case 1: offset = data8[i]; break;
+        case 2: offset = data16[i]; break;
+        case 4: offset = data32[i]; break;
+        default: offset = data64[i]; break;
+    }
+    return static_cast<int64_t>(static_cast<uint64_t>(b.base) + offset);
+}
+
+size_t PackedColumn::memoryUsage() const {
+    return blocks.capacity() * sizeof(Block) + data8.capacity() + data16.capacity() * sizeof(uint16_t) +
+           data32.capacity() * sizeof(uint32_t) + data64.capacity() * sizeof(uint64_t);
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Integer column compressed by frame of reference, block by block
+ *
+ * Every block of BLOCK_SIZE consecutive rows stores its smallest value once and
+ * each row as an unsigned offset from it, in the narrowest of 1, 2, 4 or 8
+ * bytes that holds the block's range. The offsets of a block are contiguous in
+ * the array of their width, so scan kernels can run on them directly.
+ */
+class PackedColumn {
+public:
+    static constexpr size_t BLOCK_SIZE = 256;
+    
+    /**
+     * Frame of one block
+     */
+    struct Block {
+        int64_t base;       // Smallest value in the block
+        size_t offset;      // Position of the block's first row in the array of its width
+        uint8_t width;      // Bytes per row: 1, 2, 4 or 8
+    };
+    
+    PackedColumn() = default;
+    
+    /**
+     * Pack a column
+     * @param values Column values
+     * @param min_width Narrowest width to use (2 for columns scanned with the 16/32-bit kernels)
+     */
+    explicit PackedColumn(const std::vector<int64_t>& values, uint8_t min_width = 1);
+    
+    size_t size() const { return rows; }
+    
+    size_t blockCount() const { return blocks.size(); }
+    
+    const Block& block(size_t b) const { return blocks[b]; }
+    
+    /**
+     * Value of one row
+     */
+    int64_t at(size_t row) const;
+    
+    /**
+     * Offsets of a block, for the array matching its width
+     */
+    const uint16_t* offsets16(const Block& block) const { return data16.data() + block.offset; }
+    const uint32_t* offsets32(const Block& block) const { return data32.data() + block.offset; }
+    const uint64_t* offsets64(const Block& block) const { return data64.data() + block.offset; }
+    
+    /**
+     * Heap memory held, in bytes
+     */
+    size_t memoryUsage() const;
+    
+private:
+    size_t rows = 0;
+    std::vector<Block> blocks;
+    std::vector<uint8_t> data8;
+    std::vector<uint16_t> data16;
+    std::vector<uint32_t> data32;
+    std::vector<uint64_t> data64;
+};
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include "QueryBackend.h"
+#include <algorithm>
+#include <queue>
+
+AggregateResult QueryBackend::executeAggregate(const CropRequest& request, OutputMode mode) {
+    CropRequest all_points = request;
+    all_points.limit.reset();
+    all_points.after.reset();
+    return aggregatePoints(executeCrop(all_points), mode);
+}
+
+std::vector<Point> mergeSortedPoints(const std::vector<std::vector<Point>>& parts, std::optional<size_t> limit) {
+    size_t total = 0;
+    for (const auto& part : parts) {
+        total += part.size();
+    }
+    if (limit.has_value()) {
+        total = std::min(total, limit.value());
+    }
+    
+    std::vector<Point> merged;
+    merged.reserve(total);
+    
+    // Heap of (part, position) ordered by the point at that position, smallest first
+    using Cursor = std::pair<size_t, size_t>;
+    auto greater = [&parts](const Cursor& a, const Cursor& b) {
+        return parts[b.first][b.second] < parts[a.first][a.second];
+    };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(greater)> heap(greater);
+    
+    for (size_t p = 0; p < parts.size(); ++p) {
+        if (!parts[p].empty()) {
+            heap.emplace(p, 0);
+        }
+    }
+    
+    while (!heap.empty() && merged.size() < total) {
+        auto [p, i] = heap.top();
+        heap.pop();
+        merged.push_back(parts[p][i]);
+        if (i + 1 < parts[p].size()) {
+            heap.emplace(p, i + 1);
+        }
+    }
+    
+    return merged;
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+#include "../geometry/Point.h"
+#include "../query/AggregateResult.h"
+#include "../query/CropRequest.h"
+
+/**
+ * Source of crop query results behind QueryEngine
+ *
+ * Every backend answers a request with the same points: those inside the crop
+ * region that pass the category, group and proper filters, sorted by (y, x, id),
+ * starting after the keyset cursor and truncated to the limit.
+ */
+class QueryBackend {
+public:
+    virtual ~QueryBackend() = default;
+    
+    /**
+     * Short name used in logs and on the command line (e.g. "database")
+     */
+    virtual std::string getName() const = 0;
+    
+    /**
+     * Execute a crop query
+     * @param request Crop parameters
+     * @return Matching points sorted by (y, x, id)
+     */
+    virtual std::vector<Point> executeCrop(const CropRequest& request) = 0;
+    
+    /**
+     * Compute an aggregate over all matching points (limit and cursor are ignored)
+     * The default implementation aggregates the points returned by executeCrop.
+     * @param request Crop parameters
+     * @param mode Aggregate to compute (any mode except OutputMode::Points)
+     */
+    virtual AggregateResult executeAggregate(const CropRequest& request, OutputMode mode);
+    
+    /**
+     * Check that the backend can serve queries
+     */
+    virtual bool testConnection() { return true; }
+};
+
+/**
+ * K-way merge of sorted partial results (shards, parallel scan morsels)
+ * @param parts Partial results, each sorted by (y, x, id)
+ * @param limit Optional maximum number of merged points
+ */
+std::vector<Point> mergeSortedPoints(const std::vector<std::vector<Point>>& parts, std::optional<size_t> limit);
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include "RTreeBackend.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+RTreeBackend::RTreeBackend(const std::vector<Point>& all_points, size_t capacity)
+    : InMemoryBackend(all_points), node_capacity(std::max<size_t>(2, capacity)), points(all_points) {
+    if (points.size() > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("R-tree supports at most 2^32 points");
+    }
+    
+    // Leaf level: tile the points, then one node per run of node_capacity points
+    tile(points, [](const Point& p) { return p.x; }, [](const Point& p) { return p.y; });
+    
+    std::vector<Node> leaves;
+    leaves.reserve((points.size() + node_capacity - 1) / node_capacity);
+    for (size_t first = 0; first < points.size(); first += node_capacity) {
+        size_t last = std::min(points.size(), first + node_capacity);
+        Node leaf{points[first].x, points[first].y, points[first].x, points[first].y,
+                  static_cast<uint32_t>(first), static_cast<uint32_t>(last - first)};
+        for (size_t i = first + 1; i < last; ++i) {
+            leaf.min_x = std::min(leaf.min_x, points[i].x);
+            leaf.min_y = std::min(leaf.min_y, points[i].y);
+            leaf.max_x = std::max(leaf.max_x, points[i].x);
+            leaf.max_y = std::max(leaf.max_y, points[i].y);
+        }
+        leaves.push_back(leaf);
+    }
+    
+    // An empty table has no levels at all, so planSearch never looks for a root
+    if (!leaves.empty()) {
+        levels.push_back(std::move(leaves));
+    }
+    
+    // Upper levels until a single root remains
+    while (!levels.empty() && levels.back().size() > 1) {
+        std::vector<Node> parents = packLevel(levels.back());
+        levels.push_back(std::move(parents));
+    }
+    
+    std::cout << "R-tree built: " << points.size() << " points, " << levels.size() << " levels, "
+              << (levels.empty() ? 0 : levels[0].size()) << " leaves" << std::endl;
+}
+
+template <typename T, typename KeyX, typename KeyY>
+void RTreeBackend::tile(std::vector<T>& items, KeyX center_x, KeyY center_y) const {
+    size_t tiles = (items.size() + node_capacity - 1) / node_capacity;
+    size_t slices = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(tiles))));
+    size_t slice_size = std::max<size_t>(1, slices) * node_capacity;
+    
+    std::sort(items.begin(), items.end(),
+              [&center_x](const T& a, const T& b) { return center_x(a) < center_x(b); });
+    
+    for (size_t first = 0; first < items.size(); first += slice_size) {
+        auto slice_end = items.begin() + std::min(items.size(), first + slice_size);
+        std::sort(items.begin() + first, slice_end,
+                  [&center_y](const T& a, const T& b) { return center_y(a) < center_y(b); });
+    }
+}
+
+std::vector<RTreeBackend::Node> RTreeBackend::packLevel(std::vector<Node>& children) const {
+    tile(children,
+         [](const Node& n) { return n.min_x + n.max_x; },
+         [](const Node& n) { return n.min_y + n.max_y; });
+    
+    std::vector<Node> parents;
+    parents.reserve((children.size() + node_capacity - 1) / node_capacity);
+    for (size_t first = 0; first < children.size(); first += node_capacity) {
+        size_t last = std::min(children.size(), first + node_capacity);
+        Node parent = children[first];
+        parent.first = static_cast<uint32_t>(first);
+        parent.count = static_cast<uint32_t>(last - first);
+        for (size_t i = first + 1; i < last; ++i) {
+            parent.min_x = std::min(parent.min_x, children[i].min_x);
+            parent.min_y = std::min(parent.min_y, children[i].min_y);
+            parent.max_x = std::max(parent.max_x, children[i].max_x);
+            parent.max_y = std::max(parent.max_y, children[i].max_y);
+        }
+        parents.push_back(parent);
+    }
+    return parents;
+}
+
+size_t RTreeBackend::memoryUsage() const {
+    size_t bytes = points.capacity() * sizeof(Point);
+    for (const auto& level : levels) {
+        bytes += level.capacity() * sizeof(Node);
+    }
+    return bytes;
+}
+
+void RTreeBackend::planSearch(const Rectangle& crop, const CropFilter& /*filter*/, std::vector<SearchRange>& ranges) const {
+    if (levels.empty()) {
+        return;
+    }
+    
+    // Depth-first over (level, node index); the root level has a single node
+    std::vector<std::pair<size_t, uint32_t>> stack;
+    stack.emplace_back(levels.size() - 1, 0);
+    
+    while (!stack.empty()) {
+        auto [level, index] = stack.back();
+        stack.pop_back();
+        const Node& node = levels[level][index];
+        
+        if (node.max_x < crop.p_min.x || node.min_x > crop.p_max.x ||
+            node.max_y < crop.p_min.y || node.min_y > crop.p_max.y) {
+            continue;
+        }
+        
+        if (level > 0) {
+            for (uint32_t child = node.first; child < node.first + node.count; ++child) {
+                stack.emplace_back(level - 1, child);
+            }
+            continue;
+        }
+        
+        // Leaf points; tag 1 marks leaves entirely inside the crop
+        bool inside = node.min_x >= crop.p_min.x && node.max_x <= crop.p_max.x &&
+                      node.min_y >= crop.p_min.y && node.max_y <= crop.p_max.y;
+        ranges.push_back({node.first, node.first + node.count, inside ? 1u : 0u});
+    }
+}
+
+void RTreeBackend::scanRanges(const Rectangle& crop, const CropFilter& filter, const std::vector<SearchRange>& ranges,
+                              std::vector<Point>& out, size_t /*max_results*/) const {
+    filter.dispatch([&](const auto& accepts) {
+        for (const auto& range : ranges) {
+            bool inside = range.tag != 0;
+            for (size_t i = range.first; i < range.last; ++i) {
+                const Point& point = points[i];
+                if ((inside || crop.contains(point)) && accepts(point)) {
+                    out.push_back(point);
+                }
+            }
+        }
+    });
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "InMemoryBackend.h"
+
+/**
+ * In-memory packed R-tree built with Sort-Tile-Recursive (STR) bulk loading
+ *
+ * Points are sorted by x into vertical slices, each slice sorted by y and cut
+ * into full leaves; the same tiling is applied to node centers level by level.
+ * Leaves are stored back to back in one point array and every level is a
+ * contiguous node array, so the tree is pointer-free and nearly 100% full.
+ * Nodes entirely inside the crop rectangle are reported without per-point
+ * rectangle tests.
+ */
+class RTreeBackend : public InMemoryBackend {
+private:
+    struct Node {
+        double min_x, min_y, max_x, max_y;
+        uint32_t first;  // First point (leaf level) or first child in the level below
+        uint32_t count;  // Number of points or children
+    };
+    
+    size_t node_capacity;
+    std::vector<Point> points;             // Leaf order
+    std::vector<std::vector<Node>> levels; // levels[0] = leaves, levels.back() = root level
+
+public:
+    /**
+     * Bulk-load the tree
+     * @param all_points Snapshot of all points
+     * @param capacity Maximum entries per node
+     */
+    explicit RTreeBackend(const std::vector<Point>& all_points, size_t capacity = 16);
+    
+    std::string getName() const override { return "rtree"; }
+    
+    size_t memoryUsage() const override;
+    
+    size_t size() const override { return points.size(); }
+    
+    /**
+     * Number of tree levels including the leaf level
+     */
+    size_t height() const { return levels.size(); }
+
+protected:
+    void planSearch(const Rectangle& crop, const CropFilter& filter, std::vector<SearchRange>& ranges) const override;
+    
+    void scanRanges(const Rectangle& crop, const CropFilter& filter, const std::vector<SearchRange>& ranges,
+                    std::vector<Point>& out, size_t max_results) const override;
+
+private:
+    /**
+     * Build the level above `children` (which is reordered into STR tile order)
+     */
+    std::vector<Node> packLevel(std::vector<Node>& children) const;
+    
+    /**
+     * Reorder items so that consecutive runs of node_capacity form STR tiles
+     * @param items Items to reorder
+     * @param center_x Key for the slice sort
+     * @param center_y Key for the sort within a slice
+     */
+    template <typename T, typename KeyX, typename KeyY>
+    void tile(std::vector<T>& items, KeyX center_x, KeyY center_y) const;
+};
\ No newline at end of file
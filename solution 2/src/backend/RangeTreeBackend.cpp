@@ -0,0 +1,139 @@
+#include "RangeTreeBackend.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+bool lessByY(const Point& a, const Point& b) {
+    if (a.y != b.y) return a.y < b.y;
+    if (a.x != b.x) return a.x < b.x;
+    return a.id < b.id;
+}
+
+}
+
+RangeTreeBackend::RangeTreeBackend(const std::vector<Point>& all_points)
+    : InMemoryBackend(all_points), points(all_points) {
+    if (points.size() >= UINT32_MAX) {
+        throw std::runtime_error("Range tree supports fewer than 2^32 points");
+    }
+    
+    std::sort(points.begin(), points.end(), [](const Point& a, const Point& b) {
+        if (a.x != b.x) return a.x < b.x;
+        if (a.y != b.y) return a.y < b.y;
+        return a.id < b.id;
+    });
+    
+    size_t n = points.size();
+    xs.reserve(n);
+    for (const auto& point : points) {
+        xs.push_back(point.x);
+    }
+    
+    // Level 0: blocks of one point, in x order
+    order.emplace_back(n);
+    cascade.emplace_back();
+    for (size_t i = 0; i < n; ++i) {
+        order[0][i] = static_cast<uint32_t>(i);
+    }
+    
+    // Level d merges pairs of level d-1 blocks by y, recording where each entry came from
+    for (size_t width = 2; width / 2 < n; width *= 2) {
+        const std::vector<uint32_t>& below = order.back();
+        std::vector<uint32_t> merged(n);
+        std::vector<uint32_t> left_before(n);
+        
+        for (size_t block = 0; block < n; block += width) {
+            size_t middle = std::min(n, block + width / 2);
+            size_t end = std::min(n, block + width);
+            size_t l = block, r = middle, out = block;
+            
+            while (out < end) {
+                bool take_left = r == end || (l < middle && lessByY(points[below[l]], points[below[r]]));
+                left_before[out] = static_cast<uint32_t>(l - block);
+                merged[out++] = take_left ? below[l++] : below[r++];
+            }
+        }
+        
+        order.push_back(std::move(merged));
+        cascade.push_back(std::move(left_before));
+    }
+    
+    root_ys.reserve(n);
+    for (uint32_t index : order.back()) {
+        root_ys.push_back(points[index].y);
+    }
+    
+    std::cout << "Range tree built: " << n << " points, " << order.size() << " levels, "
+              << memoryUsage() / (1024 * 1024) << " MiB" << std::endl;
+}
+
+size_t RangeTreeBackend::memoryUsage() const {
+    size_t bytes = points.capacity() * sizeof(Point) + xs.capacity() * sizeof(double) +
+                   root_ys.capacity() * sizeof(double);
+    for (size_t d = 0; d < order.size(); ++d) {
+        bytes += order[d].capacity() * sizeof(uint32_t) + cascade[d].capacity() * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+size_t RangeTreeBackend::toLeft(size_t level, size_t block_first, size_t position) const {
+    size_t left_size = std::min(points.size(), block_first + (size_t(1) << (level - 1))) - block_first;
+    size_t block_size = std::min(points.size(), block_first + (size_t(1) << level)) - block_first;
+    return position == block_size ? left_size : cascade[level][block_first + position];
+}
+
+void RangeTreeBackend::report(size_t level, size_t block_first, size_t x_first, size_t x_last,
+                              size_t y_first, size_t y_last, std::vector<SearchRange>& ranges) const {
+    if (y_first >= y_last) {
+        return;
+    }
+    
+    size_t block_end = std::min(points.size(), block_first + (size_t(1) << level));
+    if (x_last <= block_first || x_first >= block_end) {
+        return;
+    }
+    
+    // Canonical block: every entry in the y range has its x inside the crop (tag = level)
+    if (x_first <= block_first && block_end <= x_last) {
+        ranges.push_back({block_first + y_first, block_first + y_last, static_cast<uint32_t>(level)});
+        return;
+    }
+    
+    // Cascade the y range into both children
+    size_t left_first = toLeft(level, block_first, y_first);
+    size_t left_last = toLeft(level, block_first, y_last);
+    size_t right_block = block_first + (size_t(1) << (level - 1));
+    
+    report(level - 1, block_first, x_first, x_last, left_first, left_last, ranges);
+    report(level - 1, right_block, x_first, x_last, y_first - left_first, y_last - left_last, ranges);
+}
+
+void RangeTreeBackend::planSearch(const Rectangle& crop, const CropFilter& /*filter*/, std::vector<SearchRange>& ranges) const {
+    if (points.empty()) {
+        return;
+    }
+    
+    size_t x_first = std::lower_bound(xs.begin(), xs.end(), crop.p_min.x) - xs.begin();
+    size_t x_last = std::upper_bound(xs.begin(), xs.end(), crop.p_max.x) - xs.begin();
+    size_t y_first = std::lower_bound(root_ys.begin(), root_ys.end(), crop.p_min.y) - root_ys.begin();
+    size_t y_last = std::upper_bound(root_ys.begin(), root_ys.end(), crop.p_max.y) - root_ys.begin();
+    
+    report(order.size() - 1, 0, x_first, x_last, y_first, y_last, ranges);
+}
+
+void RangeTreeBackend::scanRanges(const Rectangle& /*crop*/, const CropFilter& filter, const std::vector<SearchRange>& ranges,
+                                  std::vector<Point>& out, size_t /*max_results*/) const {
+    filter.dispatch([&](const auto& accepts) {
+        for (const auto& range : ranges) {
+            const std::vector<uint32_t>& entries = order[range.tag];
+            for (size_t i = range.first; i < range.last; ++i) {
+                const Point& point = points[entries[i]];
+                if (accepts(point)) {
+                    out.push_back(point);
+                }
+            }
+        }
+    });
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "InMemoryBackend.h"
+
+/**
+ * Static 2D layered range tree with fractional cascading
+ *
+ * The points are sorted by x; level d of the tree cuts that order into aligned
+ * blocks of 2^d points and keeps every block sorted by y. For each entry, a
+ * cascade count records how many of the block's entries before it came from the
+ * left child, which maps a y position in a block to the matching positions in
+ * both children in O(1). A crop costs one binary search on x, one on y at the
+ * root, then O(log n) canonical blocks, each reported as a contiguous y run:
+ * O(log n + k) regardless of the point distribution, for O(n log n) memory.
+ */
+class RangeTreeBackend : public InMemoryBackend {
+private:
+    std::vector<Point> points;                   // Sorted by (x, y, id)
+    std::vector<double> xs;                      // x column of points, for the x binary search
+    std::vector<double> root_ys;                 // y of the root level entries, for the y binary search
+    std::vector<std::vector<uint32_t>> order;    // order[d][i]: point at position i of level d
+    std::vector<std::vector<uint32_t>> cascade;  // cascade[d][i]: left-child entries before position i in its block (d >= 1)
+
+public:
+    /**
+     * Build all levels by bottom-up merging
+     * @param all_points Snapshot of all points
+     */
+    explicit RangeTreeBackend(const std::vector<Point>& all_points);
+    
+    std::string getName() const override { return "rangetree"; }
+    
+    size_t memoryUsage() const override;
+    
+    size_t size() const override { return points.size(); }
+
+protected:
+    void planSearch(const Rectangle& crop, const CropFilter& filter, std::vector<SearchRange>& ranges) const override;
+    
+    void scanRanges(const Rectangle& crop, const CropFilter& filter, const std::vector<SearchRange>& ranges,
+                    std::vector<Point>& out, size_t max_results) const override;
+
+private:
+    /**
+     * Report the canonical blocks of x positions [x_first, x_last) below one block
+     * @param level Level of the block
+     * @param block_first First x position of the block
+     * @param y_first First position of the y range within the block
+     * @param y_last End of the y range within the block
+     * @param ranges Destination for the y runs of the canonical blocks (tag = level)
+     */
+    void report(size_t level, size_t block_first, size_t x_first, size_t x_last,
+                size_t y_first, size_t y_last, std::vector<SearchRange>& ranges) const;
+    
+    /**
+     * Map a position within a block to the same y position in its left child
+     */
+    size_t toLeft(size_t level, size_t block_first, size_t position) const;
+};
\ No newline at end of file
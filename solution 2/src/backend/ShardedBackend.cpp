@@ -0,0 +1,125 @@
+#include "ShardedBackend.h"
+#include <algorithm>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+
+ShardedBackend::ShardedBackend(const std::vector<std::string>& connection_strings, size_t pool_size) {
+    if (connection_strings.empty()) {
+        throw std::runtime_error("Sharded backend needs at least one shard");
+    }
+    
+    for (const auto& connection_string : connection_strings) {
+        Shard shard;
+        shard.connection_string = connection_string;
+        shard.db_manager = std::make_unique<DatabaseManager>(connection_string, pool_size);
+        shards.push_back(std::move(shard));
+    }
+}
+
+std::optional<CropRequest> ShardedBackend::routeRequest(const CropRequest& request, size_t shard) const {
+    // Proper groups lie inside the valid region, so only those can match
+    std::optional<Rectangle> within;
+    if (request.proper_constraint.value_or(false)) {
+        within = request.valid_region;
+    }
+    
+    // Read per query: points and groups added since the last crop must not be pruned away
+    std::optional<std::vector<long long>> reaching =
+        shards[shard].db_manager->getGroupsReaching(request.crop_region, within, request.group_filter);
+    if (!reaching) {
+        return request;
+    }
+    if (reaching->empty()) {
+        return std::nullopt;
+    }
+    
+    // Only the listed groups that live on this shard and reach the crop
+    CropRequest shard_request = request;
+    if (!request.group_filter.empty()) {
+        shard_request.group_filter = std::move(*reaching);
+    }
+    return shard_request;
+}
+
+std::vector<Point> ShardedBackend::executeCrop(const CropRequest& request) {
+    // Scatter: one task per shard, each on that shard's own pool; pruned shards return nothing
+    std::vector<std::future<std::optional<std::vector<Point>>>> futures;
+    for (size_t s = 0; s < shards.size(); ++s) {
+        futures.push_back(std::async(std::launch::async, [this, s, &request]() -> std::optional<std::vector<Point>> {
+            std::optional<CropRequest> shard_request = routeRequest(request, s);
+            if (!shard_request) {
+                return std::nullopt;
+            }
+            return shards[s].db_manager->executeCropQuery(
+                shard_request->crop_region,
+                shard_request->valid_region,
+                shard_request->category_filter,
+                shard_request->group_filter,
+                shard_request->proper_constraint,
+                shard_request->limit,
+                shard_request->after
+            );
+        }));
+    }
+    
+    // Gather
+    std::vector<std::vector<Point>> parts;
+    parts.reserve(futures.size());
+    for (auto& future : futures) {
+        if (std::optional<std::vector<Point>> part = future.get()) {
+            parts.push_back(std::move(*part));
+        }
+    }
+    
+    std::cout << "Crop served by " << parts.size() << " of " << shards.size() << " shards" << std::endl;
+    
+    return mergeSortedPoints(parts, request.limit);
+}
+
+AggregateResult ShardedBackend::executeAggregate(const CropRequest& request, OutputMode mode) {
+    std::vector<std::future<std::optional<AggregateResult>>> futures;
+    for (size_t s = 0; s < shards.size(); ++s) {
+        futures.push_back(std::async(std::launch::async, [this, s, &request, mode]() -> std::optional<AggregateResult> {
+            std::optional<CropRequest> shard_request = routeRequest(request, s);
+            if (!shard_request) {
+                return std::nullopt;
+            }
+            return shards[s].db_manager->executeAggregateQuery(
+                shard_request->crop_region,
+                shard_request->valid_region,
+                mode,
+                shard_request->category_filter,
+                shard_request->group_filter,
+                shard_request->proper_constraint
+            );
+        }));
+    }
+    
+    AggregateResult merged(mode);
+    for (auto& future : futures) {
+        if (std::optional<AggregateResult> part = future.get()) {
+            mergeAggregateResults(merged, *part);
+        }
+    }
+    
+    return merged;
+}
+
+bool ShardedBackend::testConnection() {
+    for (auto& shard : shards) {
+        if (!shard.db_manager->testConnection()) {
+            std::cerr << "Shard connection failed: " << shard.connection_string << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<Point> ShardedBackend::getAllPoints() {
+    std::vector<std::vector<Point>> parts;
+    for (auto& shard : shards) {
+        parts.push_back(shard.db_manager->getAllPoints());  // Already in (y, x, id) order
+    }
+    return mergeSortedPoints(parts, std::nullopt);
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "QueryBackend.h"
+#include "../database/DatabaseManager.h"
+
+/**
+ * Backend that spreads the data over several PostgreSQL instances
+ *
+ * The data loader places all points of a group on one shard, so proper checks
+ * are answered locally by each shard. A crop is scattered to every shard in
+ * parallel; each shard first checks its group_extent (kept current by triggers)
+ * and skips the crop when none of its groups can contribute. The
+ * (y, x, id)-sorted partial results are k-way merged.
+ */
+class ShardedBackend : public QueryBackend {
+private:
+    struct Shard {
+        std::string connection_string;
+        std::unique_ptr<DatabaseManager> db_manager;
+    };
+    
+    std::vector<Shard> shards;
+
+public:
+    /**
+     * Connect to every shard
+     * @param connection_strings One PostgreSQL connection string per shard
+     * @param pool_size Connection pool size per shard
+     */
+    ShardedBackend(const std::vector<std::string>& connection_strings, size_t pool_size = 4);
+    
+    std::string getName() const override { return "sharded"; }
+    
+    std::vector<Point> executeCrop(const CropRequest& request) override;
+    
+    /**
+     * Each involved shard computes the aggregate in SQL; the partial aggregates are merged
+     */
+    AggregateResult executeAggregate(const CropRequest& request, OutputMode mode) override;
+    
+    bool testConnection() override;
+    
+    /**
+     * Load all points of all shards, sorted by (y, x, id) (for brute force testing)
+     */
+    std::vector<Point> getAllPoints();
+    
+    size_t getShardCount() const { return shards.size(); }
+
+private:
+    /**
+     * Restrict a request to one shard, from the shard's current group extents
+     * @param request Crop parameters
+     * @param shard Shard index
+     * @return The request narrowed to the listed groups on the shard, or nullopt when the shard cannot contribute
+     */
+    std::optional<CropRequest> routeRequest(const CropRequest& request, size_t shard) const;
+};
\ No newline at end of file
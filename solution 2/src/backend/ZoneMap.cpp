@@ -0,0 +1,77 @@
+#include "ZoneMap.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/**
+ * Widen [low, high] to value; a NaN makes both bounds NaN for good, so the block is never skipped or taken whole
+ */
+void widen(double& low, double& high, double value) {
+    if (std::isnan(value) || std::isnan(low)) {
+        low = high = std::numeric_limits<double>::quiet_NaN();
+        return;
+    }
+    low = std::min(low, value);
+    high = std::max(high, value);
+}
+
+} // namespace
+
+ZoneMap::ZoneMap(const std::vector<Point>& sorted) {
+    zones.reserve((sorted.size() + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    
+    for (size_t first = 0; first < sorted.size(); first += BLOCK_SIZE) {
+        size_t last = std::min(sorted.size(), first + BLOCK_SIZE);
+        Zone zone{sorted[first].x, sorted[first].x, sorted[first].y, sorted[first].y,
+                  sorted[first].group_id, sorted[first].group_id, 0};
+        
+        for (size_t i = first; i < last; ++i) {
+            const Point& point = sorted[i];
+            widen(zone.min_x, zone.max_x, point.x);
+            widen(zone.min_y, zone.max_y, point.y);
+            zone.min_group = std::min(zone.min_group, point.group_id);
+            zone.max_group = std::max(zone.max_group, point.group_id);
+            zone.categories |= categoryBit(point.category);
+        }
+        zones.push_back(zone);
+    }
+}
+
+ZoneMap::Probe::Probe(const ZoneMap& zones, const Rectangle& crop, const CropFilter& filter)
+    : zones(&zones), crop(crop), categories(~uint64_t(0)), restrict_groups(filter.restrict_groups),
+      groups(&filter.sorted_groups), filter(&filter) {
+    if (!filter.categories.empty()) {
+        categories = 0;
+        for (int category : filter.categories.list()) {
+            categories |= categoryBit(category);
+        }
+    }
+}
+
+ZoneMap::Overlap ZoneMap::Probe::test(size_t row) const {
+    const Zone& zone = zones->zone(row / BLOCK_SIZE);
+    
+    // Any comparison with a NaN bound is false, which keeps such blocks PARTIAL
+    if (zone.max_x < crop.p_min.x || zone.min_x > crop.p_max.x ||
+        zone.max_y < crop.p_min.y || zone.min_y > crop.p_max.y) {
+        return Overlap::NONE;
+    }
+    if ((zone.categories & categories) == 0) {
+        return Overlap::NONE;
+    }
+    if (restrict_groups) {
+        auto it = std::lower_bound(groups->begin(), groups->end(), zone.min_group);
+        if (it == groups->end() || *it > zone.max_group) {
+            return Overlap::NONE;
+        }
+    }
+    if (zone.min_group == zone.max_group && filter->excluded.count(zone.min_group) > 0) {
+        return Overlap::NONE;
+    }
+    
+    bool inside = crop.p_min.x <= zone.min_x && zone.max_x <= crop.p_max.x &&
+                  crop.p_min.y <= zone.min_y && zone.max_y <= crop.p_max.y;
+    return inside ? Overlap::INSIDE : Overlap::PARTIAL;
+}
\ No newline at end of file
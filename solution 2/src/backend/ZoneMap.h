@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CropFilter.h"
+#include "../geometry/Point.h"
+#include "../geometry/Rectangle.h"
+
+/**
+ * Per-block summaries of a sorted column store, for skipping blocks a crop cannot match
+ *
+ * Rows are cut into blocks of BLOCK_SIZE consecutive positions. Each block
+ * keeps the bounds of its x, y and group ids and a 64-bit presence bitmap of
+ * its categories (bit category mod 64, so it can only say "absent" for sure).
+ * A Probe built per scan classifies blocks from these alone: outside
+ * the crop or the filters, entirely inside the rectangle, or neither.
+ */
+class ZoneMap {
+public:
+    static constexpr size_t BLOCK_SIZE = 256;
+    
+    /**
+     * Summary of one block
+     */
+    struct Zone {
+        double min_x, max_x;
+        double min_y, max_y;
+        long long min_group, max_group;
+        uint64_t categories;
+    };
+    
+    /**
+     * How a block relates to a crop
+     */
+    enum class Overlap {
+        NONE,       // No row can match: skip the block
+        PARTIAL,    // Rows need the rectangle test
+        INSIDE      // Every row lies inside the rectangle; only the filters remain
+    };
+    
+    /**
+     * Block test for one crop and filter
+     */
+    class Probe {
+    public:
+        /**
+         * @param filter Query filter; its sorted_groups must be filled (CropFilter::sortGroups) when it restricts groups
+         */
+        Probe(const ZoneMap& zones, const Rectangle& crop, const CropFilter& filter);
+        
+        /**
+         * Classify the block holding the given row
+         */
+        Overlap test(size_t row) const;
+        
+    private:
+        const ZoneMap* zones;
+        Rectangle crop;
+        uint64_t categories;                // Bits of the category filter, all set if none
+        bool restrict_groups;
+        const std::vector<long long>* groups;   // Group filter, sorted (CropFilter::sorted_groups)
+        const CropFilter* filter;
+    };
+    
+    ZoneMap() = default;
+    
+    /**
+     * Summarize points stored in this order
+     * @param sorted Points in storage order
+     */
+    explicit ZoneMap(const std::vector<Point>& sorted);
+    
+    size_t blockCount() const { return zones.size(); }
+    
+    const Zone& zone(size_t block) const { return zones[block]; }
+    
+    /**
+     * Heap memory held, in bytes
+     */
+    size_t memoryUsage() const { return zones.capacity() * sizeof(Zone); }
+    
+    /**
+     * Presence bit of a category
+     */
+    static uint64_t categoryBit(int category) { return uint64_t(1) << (static_cast<unsigned>(category) % 64); }
+    
+private:
+    std::vector<Zone> zones;
+};
\ No newline at end of file
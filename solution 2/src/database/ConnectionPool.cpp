@@ -0,0 +1,184 @@
+#include "ConnectionPool.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+ConnectionPool::Handle::Handle(ConnectionPool* owner, std::unique_ptr<pqxx::connection> conn)
+    : pool(owner), connection(std::move(conn)) {
+}
+
+ConnectionPool::Handle::Handle(Handle&& other) noexcept
+    : pool(other.pool), connection(std::move(other.connection)) {
+    other.pool = nullptr;
+}
+
+ConnectionPool::Handle& ConnectionPool::Handle::operator=(Handle&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool = other.pool;
+        connection = std::move(other.connection);
+        other.pool = nullptr;
+    }
+    return *this;
+}
+
+ConnectionPool::Handle::~Handle() {
+    release();
+}
+
+void ConnectionPool::Handle::invalidate() {
+    if (connection && connection->is_open()) {
+        connection->close();
+    }
+    release();
+}
+
+void ConnectionPool::Handle::release() {
+    if (pool && connection) {
+        pool->release(std::move(connection));
+    }
+    pool = nullptr;
+}
+
+ConnectionPool::ConnectionPool(const std::string& conn_str,
+                               size_t max_size,
+                               std::chrono::milliseconds health_check_interval,
+                               std::chrono::milliseconds acquire_timeout)
+    : connection_string(conn_str),
+      max_size(max_size == 0 ? 1 : max_size),
+      health_check_interval(health_check_interval),
+      acquire_timeout(acquire_timeout) {
+}
+
+ConnectionPool::~ConnectionPool() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : idle) {
+        if (entry.connection && entry.connection->is_open()) {
+            entry.connection->close();
+        }
+    }
+    idle.clear();
+}
+
+std::optional<ConnectionPool::Handle> ConnectionPool::take(std::unique_lock<std::mutex>& lock) {
+    // Reuse an idle connection if possible (most recently used first)
+    while (!idle.empty()) {
+        IdleConnection entry = std::move(idle.back());
+        idle.pop_back();
+
+        bool needs_check = std::chrono::steady_clock::now() - entry.last_used >= health_check_interval;
+        if (!needs_check && entry.connection->is_open()) {
+            lock.unlock();
+            return Handle(this, std::move(entry.connection));
+        }
+
+        // Validate outside the lock so other threads are not blocked on a round trip
+        lock.unlock();
+        bool healthy = entry.connection->is_open() && isHealthy(*entry.connection);
+        if (healthy) {
+            return Handle(this, std::move(entry.connection));
+        }
+        std::cerr << "Discarding unhealthy pooled connection" << std::endl;
+        entry.connection.reset();
+        lock.lock();
+        --open_count;
+    }
+
+    // Lazily open a new connection while below capacity
+    if (open_count < max_size) {
+        ++open_count;
+        lock.unlock();
+        return Handle(this, openConnection());
+    }
+
+    return std::nullopt;
+}
+
+ConnectionPool::Handle ConnectionPool::acquire() {
+    // One deadline for the whole call: wakeups that find nothing (spurious, or a release another
+    // waiter took first) must not restart the timeout
+    auto deadline = std::chrono::steady_clock::now() + acquire_timeout;
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        if (std::optional<Handle> handle = take(lock)) {
+            return std::move(*handle);
+        }
+
+        if (available.wait_until(lock, deadline) == std::cv_status::timeout && idle.empty()
+            && open_count >= max_size) {
+            throw std::runtime_error("Timed out waiting for a database connection (pool size " +
+                                     std::to_string(max_size) + ")");
+        }
+    }
+}
+
+std::optional<ConnectionPool::Handle> ConnectionPool::tryAcquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    return take(lock);
+}
+
+void ConnectionPool::warmUp(size_t count) {
+    count = std::min(count, max_size);
+
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (open_count >= count) {
+                return;
+            }
+            ++open_count;
+        }
+
+        auto conn = openConnection();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        idle.push_back({std::move(conn), std::chrono::steady_clock::now()});
+        available.notify_one();
+    }
+}
+
+size_t ConnectionPool::getOpenCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return open_count;
+}
+
+size_t ConnectionPool::getIdleCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return idle.size();
+}
+
+std::unique_ptr<pqxx::connection> ConnectionPool::openConnection() {
+    try {
+        return std::make_unique<pqxx::connection>(connection_string);
+    } catch (const std::exception& e) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --open_count;
+        }
+        available.notify_one();
+        throw std::runtime_error("Database connection failed: " + std::string(e.what()));
+    }
+}
+
+void ConnectionPool::release(std::unique_ptr<pqxx::connection> conn) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (conn && conn->is_open()) {
+            idle.push_back({std::move(conn), std::chrono::steady_clock::now()});
+        } else {
+            --open_count;
+        }
+    }
+    available.notify_one();
+}
+
+bool ConnectionPool::isHealthy(pqxx::connection& conn) {
+    try {
+        pqxx::nontransaction txn(conn);
+        pqxx::result result = txn.exec("SELECT 1");
+        return result.size() == 1;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+#include <pqxx/pqxx>
+
+/**
+ * Thread-safe pool of PostgreSQL connections
+ *
+ * pqxx::connection (and any transaction on it) must not be shared between
+ * threads, so every unit of database work checks out its own connection.
+ * Connections are opened lazily up to the configured size and health-checked
+ * before being handed out again.
+ */
+class ConnectionPool {
+public:
+    /**
+     * RAII checkout handle - the connection goes back to the pool on destruction
+     */
+    class Handle {
+    private:
+        ConnectionPool* pool = nullptr;
+        std::unique_ptr<pqxx::connection> connection;
+
+    public:
+        Handle(ConnectionPool* owner, std::unique_ptr<pqxx::connection> conn);
+        Handle(Handle&& other) noexcept;
+        Handle& operator=(Handle&& other) noexcept;
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+        ~Handle();
+
+        pqxx::connection& operator*() const { return *connection; }
+        pqxx::connection* operator->() const { return connection.get(); }
+
+        /**
+         * Drop the connection instead of returning it to the pool
+         * (use after a broken_connection error)
+         */
+        void invalidate();
+
+    private:
+        void release();
+    };
+
+    /**
+     * Create a pool; no connection is opened until warmUp() or acquire()
+     * @param conn_str PostgreSQL connection string
+     * @param max_size Maximum number of simultaneously open connections
+     * @param health_check_interval Idle time after which a connection is re-validated with SELECT 1
+     * @param acquire_timeout Maximum time acquire() waits for a free connection
+     */
+    ConnectionPool(const std::string& conn_str,
+                   size_t max_size,
+                   std::chrono::milliseconds health_check_interval = std::chrono::seconds(30),
+                   std::chrono::milliseconds acquire_timeout = std::chrono::seconds(30));
+
+    /**
+     * Destructor - closes all idle connections
+     */
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    /**
+     * Check out a connection, opening a new one if the pool is below capacity
+     * @return Handle owning the connection until it goes out of scope
+     * @throws std::runtime_error if no connection becomes available in time or connecting fails
+     */
+    Handle acquire();
+
+    /**
+     * Check out a connection only if one is idle or the pool is below capacity, without waiting
+     * Lets a caller that already holds a connection take more without blocking other holders.
+     * @return Handle, or nullopt when every connection is checked out
+     * @throws std::runtime_error if connecting fails
+     */
+    std::optional<Handle> tryAcquire();
+
+    /**
+     * Open idle connections ahead of time
+     * @param count Number of connections that should be open afterwards (capped at max size)
+     */
+    void warmUp(size_t count);
+
+    size_t getMaxSize() const { return max_size; }
+
+    /**
+     * Number of connections currently open (idle + checked out)
+     */
+    size_t getOpenCount() const;
+
+    /**
+     * Number of connections waiting in the pool
+     */
+    size_t getIdleCount() const;
+
+    const std::string& getConnectionString() const { return connection_string; }
+
+private:
+    struct IdleConnection {
+        std::unique_ptr<pqxx::connection> connection;
+        std::chrono::steady_clock::time_point last_used;
+    };
+
+    std::string connection_string;
+    size_t max_size;
+    std::chrono::milliseconds health_check_interval;
+    std::chrono::milliseconds acquire_timeout;
+
+    mutable std::mutex mutex;
+    std::condition_variable available;
+    std::vector<IdleConnection> idle;
+    size_t open_count = 0;
+
+    /**
+     * Hand out an idle or newly opened connection if there is one
+     * Unlocks lock when it returns a handle; leaves it locked when it returns nullopt.
+     */
+    std::optional<Handle> take(std::unique_lock<std::mutex>& lock);
+
+    /**
+     * Open a new connection; caller must already have reserved a slot in open_count
+     */
+    std::unique_ptr<pqxx::connection> openConnection();
+
+    /**
+     * Return a connection to the pool, or discard it if it is no longer usable
+     */
+    void release(std::unique_ptr<pqxx::connection> conn);
+
+    /**
+     * Run a trivial round trip to verify the connection still works
+     */
+    static bool isHealthy(pqxx::connection& conn);
+};
\ No newline at end of file
@@ -1,27 +1,116 @@
 #include "DatabaseManager.h"
+#include "../query/PointSort.h"
 #include <iostream>
 #include <sstream>
+#include <iomanip>
 #include <algorithm>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <unordered_set>
+#include <nlohmann/json.hpp>
 
-DatabaseManager::DatabaseManager(const std::string& conn_str) : connection_string(conn_str) {
-    try {
-        connection = std::make_unique<pqxx::connection>(connection_string);
-        std::cout << "Connected to database: " << connection->dbname() << std::endl;
-    } catch (const std::exception& e) {
-        throw std::runtime_error("Database connection failed: " + std::string(e.what()));
+namespace {
+
+// Groups whose points all lie inside the valid region ($1..$4 = min_x, max_x, min_y, max_y).
+// The box containment uses idx_group_extent_box; it is slightly fuzzy (EPSILON), so the
+// exact comparisons follow.
+const char* const PROPER_GROUPS_QUERY = R"(
+            SELECT group_id 
+            FROM group_extent 
+            WHERE box(point(min_x, min_y), point(max_x, max_y)) <@ box(point($1, $3), point($2, $4))
+              AND min_x >= $1 AND max_x <= $2 
+              AND min_y >= $3 AND max_y <= $4
+        )";
+
+const char* const ALL_GROUPS_QUERY = "SELECT group_id FROM group_extent";
+
+// Fallbacks for schemas without group_extent: aggregate over every point
+const char* const PROPER_GROUPS_SCAN_QUERY = R"(
+            SELECT group_id 
+            FROM inspection_region 
+            GROUP BY group_id 
+            HAVING MIN(coord_x) >= $1 AND MAX(coord_x) <= $2 
+               AND MIN(coord_y) >= $3 AND MAX(coord_y) <= $4
+        )";
+
+const char* const ALL_GROUPS_SCAN_QUERY = "SELECT DISTINCT group_id FROM inspection_region";
+
+const char* const GROUP_EXTENTS_QUERY = R"(
+            SELECT group_id, min_x, min_y, max_x, max_y, point_count 
+            FROM group_extent 
+            WHERE point_count > 0
+        )";
+
+const char* const GROUP_EXTENTS_SCAN_QUERY = R"(
+            SELECT group_id, MIN(coord_x), MIN(coord_y), MAX(coord_x), MAX(coord_y), COUNT(*) 
+            FROM inspection_region 
+            GROUP BY group_id
+        )";
+
+// Extents of the listed groups ($1 = array of group ids)
+const char* const LISTED_GROUP_EXTENTS_QUERY = R"(
+            SELECT group_id, min_x, min_y, max_x, max_y, point_count 
+            FROM group_extent 
+            WHERE group_id = ANY($1::bigint[])
+        )";
+
+// Group filters holding at most this many points are read group by group through idx_crop_group,
+// with at most this many groups (one UNION ALL branch each)
+const size_t GROUP_BRANCH_MAX_ROWS = 50000;
+const size_t GROUP_BRANCH_MAX_GROUPS = 64;
+
+// Text form of a double that round-trips exactly
+std::string formatDouble(double value) {
+    std::ostringstream oss;
+    oss << std::setprecision(17) << value;
+    return oss.str();
+}
+
+// Keyset cursor: continue strictly after the last point of the previous page
+std::string keysetCondition(const std::optional<KeysetCursor>& after) {
+    if (!after.has_value()) {
+        return "";
     }
+    return " AND ((coord_y, coord_x, id) > (" + formatDouble(after->y) + ", " +
+           formatDouble(after->x) + ", " + std::to_string(after->id) + "))";
+}
+
+bool sameRectangle(const Rectangle& a, const Rectangle& b) {
+    return a.p_min.x == b.p_min.x && a.p_min.y == b.p_min.y &&
+           a.p_max.x == b.p_max.x && a.p_max.y == b.p_max.y;
+}
+
+} // namespace
+
+DatabaseManager::DatabaseManager(const std::string& conn_str, size_t pool_size) : connection_string(conn_str) {
+    pool = std::make_unique<ConnectionPool>(connection_string, pool_size);
+    
+    // Open one connection eagerly so configuration errors surface immediately;
+    // the rest of the pool is warmed up lazily on demand
+    {
+        auto connection = pool->acquire();
+        std::cout << "Connected to database: " << connection->dbname()
+                  << " (pool size " << pool->getMaxSize() << ")" << std::endl;
+    }
+    
+    detectCropIndexes();
+    detectGroupExtent();
+    detectSpatialKeyGrid();
 }
 
 DatabaseManager::~DatabaseManager() {
-    if (connection && connection->is_open()) {
-        connection->close();
-        std::cout << "Database connection closed." << std::endl;
+    if (pool) {
+        size_t open_connections = pool->getOpenCount();
+        pool.reset();
+        std::cout << "Database connection pool closed (" << open_connections << " connections)." << std::endl;
     }
 }
 
 bool DatabaseManager::testConnection() {
     try {
-        if (!connection || !connection->is_open()) {
+        auto connection = pool->acquire();
+        if (!connection->is_open()) {
             return false;
         }
         
@@ -41,38 +130,37 @@ std::vector<Point> DatabaseManager::executeCropQuery(
     const Rectangle& valid_region,
     const std::vector<int>& category_filter,
     const std::vector<long long>& group_filter,
-    const std::optional<bool>& proper_constraint
+    const std::optional<bool>& proper_constraint,
+    std::optional<size_t> limit,
+    const std::optional<KeysetCursor>& after
 ) {
     std::vector<long long> constraint_groups;
+    if (!resolveConstraintGroups(valid_region, proper_constraint, constraint_groups)) {
+        // No group satisfies the proper constraint
+        return {};
+    }
     
-    // Handle proper constraint if specified
-    if (proper_constraint.has_value()) {
-        // Only use valid_region when proper constraint is specified
-        std::vector<long long> proper_groups = getProperGroups(valid_region);
-        
-        if (proper_constraint.value()) {
-            // proper: true - only proper groups
-            constraint_groups = proper_groups;
-            if (constraint_groups.empty()) {
-                // No proper groups found, return empty result
-                return {};
-            }
-        } else {
-            // proper: false - only improper groups
-            // Get all groups and subtract proper groups
-            constraint_groups = getImproperGroups(valid_region, proper_groups);
-            if (constraint_groups.empty()) {
-                // No improper groups found, return empty result
-                return {};
-            }
+    // Build and execute query: a few small groups group by group, anything else over the crop's band
+    std::string query;
+    std::vector<long long> branch_groups;
+    if (selectGroupBranches(crop_region, group_filter, constraint_groups, branch_groups)) {
+        if (branch_groups.empty()) {
+            return {};
+        }
+        query = buildGroupCropQuery(crop_region, category_filter, branch_groups, limit, after);
+    } else {
+        query = buildCropQuery(crop_region, category_filter, group_filter, constraint_groups, limit, after);
+        
+        // Large unlimited crops run as parallel y-bands
+        size_t bands = std::min(parallel_bands, pool->getMaxSize());
+        if (bands > 1 && !limit.has_value() && crop_region.p_min.y < crop_region.p_max.y &&
+            estimateRows(query) >= static_cast<double>(parallel_min_rows)) {
+            return executeBandedCropQuery(crop_region, category_filter, group_filter, constraint_groups, after, bands);
         }
     }
-    // When proper_constraint is nullopt, constraint_groups remains empty and is ignored
-    
-    // Build and execute query
-    std::string query = buildCropQuery(crop_region, category_filter, group_filter, constraint_groups);
     
     try {
+        auto connection = pool->acquire();
         pqxx::work txn(*connection);
         pqxx::result result = txn.exec(query);
         txn.commit();
@@ -85,7 +173,7 @@ std::vector<Point> DatabaseManager::executeCropQuery(
         }
         
         // Sort by (y, x) as required
-        std::sort(points.begin(), points.end());
+        sortPoints(points);
         
         return points;
         
@@ -94,20 +182,470 @@ std::vector<Point> DatabaseManager::executeCropQuery(
     }
 }
 
+std::vector<Point> DatabaseManager::executeBandedCropQuery(
+    const Rectangle& crop_region,
+    const std::vector<int>& category_filter,
+    const std::vector<long long>& group_filter,
+    const std::vector<long long>& constraint_groups,
+    const std::optional<KeysetCursor>& after,
+    size_t bands
+) {
+    try {
+        // Band connections are reserved up front without waiting, so a banded crop never holds some
+        // connections while blocking on others; concurrent crops just get fewer bands (or a single one)
+        auto coordinator = pool->acquire();
+        std::vector<ConnectionPool::Handle> band_connections;
+        while (band_connections.size() + 1 < bands) {
+            std::optional<ConnectionPool::Handle> handle = pool->tryAcquire();
+            if (!handle) {
+                break;
+            }
+            band_connections.push_back(std::move(*handle));
+        }
+        
+        std::vector<Rectangle> band_regions = splitIntoBands(crop_region, band_connections.size() + 1);
+        band_connections.erase(band_connections.begin() + static_cast<long>(band_regions.size() - 1), band_connections.end());
+        
+        // The coordinator's transaction exports its snapshot and stays open until every band is done
+        pqxx::transaction<pqxx::isolation_level::repeatable_read> txn(*coordinator);
+        std::string snapshot;
+        if (band_regions.size() > 1) {
+            snapshot = txn.exec("SELECT pg_export_snapshot()")[0][0].as<std::string>();
+        }
+        
+        std::vector<std::future<std::vector<Point>>> band_results;
+        for (size_t b = 1; b < band_regions.size(); ++b) {
+            std::string band_query = buildCropQuery(band_regions[b], category_filter, group_filter,
+                                                    constraint_groups, std::nullopt, after);
+            
+            band_results.push_back(std::async(std::launch::async,
+                                              [this, band_query, snapshot, connection = std::move(band_connections[b - 1])]() {
+                pqxx::transaction<pqxx::isolation_level::repeatable_read> band_txn(*connection);
+                band_txn.exec("SET TRANSACTION SNAPSHOT " + band_txn.quote(snapshot));
+                pqxx::result result = band_txn.exec(band_query);
+                band_txn.commit();
+                
+                std::vector<Point> points;
+                points.reserve(result.size());
+                for (const auto& row : result) {
+                    points.push_back(resultToPoint(row));
+                }
+                return points;
+            }));
+        }
+        
+        // The coordinator scans the first band itself
+        pqxx::result first = txn.exec(buildCropQuery(band_regions[0], category_filter, group_filter,
+                                                     constraint_groups, std::nullopt, after));
+        
+        std::vector<Point> points;
+        points.reserve(first.size());
+        for (const auto& row : first) {
+            points.push_back(resultToPoint(row));
+        }
+        
+        // Bands are disjoint and y-ordered, each sorted by the database: concatenation is sorted
+        for (auto& band : band_results) {
+            std::vector<Point> band_points = band.get();
+            points.insert(points.end(), band_points.begin(), band_points.end());
+        }
+        
+        txn.commit();
+        return points;
+        
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Parallel band query failed: " + std::string(e.what()));
+    }
+}
+
+double DatabaseManager::estimateRows(const std::string& query) {
+    try {
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+        pqxx::result result = txn.exec("EXPLAIN (FORMAT JSON) " + query);
+        txn.commit();
+        
+        nlohmann::json plan = nlohmann::json::parse(result[0][0].as<std::string>());
+        return plan[0]["Plan"].value("Plan Rows", 0.0);
+        
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Row estimate failed: " + std::string(e.what()));
+    }
+}
+
+std::vector<Rectangle> DatabaseManager::splitIntoBands(const Rectangle& region, size_t bands) {
+    std::vector<Rectangle> result;
+    double height = (region.p_max.y - region.p_min.y) / static_cast<double>(bands);
+    double lower = region.p_min.y;
+    
+    for (size_t b = 0; b < bands; ++b) {
+        bool last = (b + 1 == bands);
+        double next = last ? region.p_max.y : region.p_min.y + height * static_cast<double>(b + 1);
+        if (!last && next <= lower) {
+            continue;  // Band too thin to be represented; the next band covers it
+        }
+        
+        // Inclusive upper bound just below the next band's lower edge
+        double upper = last ? region.p_max.y : std::nextafter(next, -std::numeric_limits<double>::infinity());
+        result.emplace_back(region.p_min.x, lower, region.p_max.x, upper);
+        lower = next;
+    }
+    
+    return result;
+}
+
+AggregateResult DatabaseManager::executeAggregateQuery(
+    const Rectangle& crop_region,
+    const Rectangle& valid_region,
+    OutputMode mode,
+    const std::vector<int>& category_filter,
+    const std::vector<long long>& group_filter,
+    const std::optional<bool>& proper_constraint
+) {
+    AggregateResult aggregate(mode);
+    
+    std::vector<long long> constraint_groups;
+    if (!resolveConstraintGroups(valid_region, proper_constraint, constraint_groups)) {
+        return aggregate;
+    }
+    
+    std::string where = buildCropConditions(crop_region, category_filter, group_filter, constraint_groups);
+    std::string query;
+    
+    switch (mode) {
+        case OutputMode::Count:
+            query = "SELECT COUNT(*) FROM inspection_region WHERE " + where;
+            break;
+        case OutputMode::PerCategory:
+            query = "SELECT category, COUNT(*) FROM inspection_region WHERE " + where +
+                    " GROUP BY category ORDER BY category";
+            break;
+        case OutputMode::PerGroup:
+            query = "SELECT group_id, COUNT(*) FROM inspection_region WHERE " + where +
+                    " GROUP BY group_id ORDER BY group_id";
+            break;
+        case OutputMode::BoundingBox:
+            query = "SELECT COUNT(*), MIN(coord_x), MIN(coord_y), MAX(coord_x), MAX(coord_y) "
+                    "FROM inspection_region WHERE " + where;
+            break;
+        case OutputMode::Points:
+            throw std::runtime_error("executeAggregateQuery does not support the points output mode");
+    }
+    
+    try {
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+        pqxx::result result = txn.exec(query);
+        txn.commit();
+        
+        if (mode == OutputMode::PerCategory || mode == OutputMode::PerGroup) {
+            aggregate.buckets.reserve(result.size());
+            for (const auto& row : result) {
+                size_t bucket_count = row[1].as<size_t>();
+                aggregate.buckets.emplace_back(row[0].as<long long>(), bucket_count);
+                aggregate.count += bucket_count;
+            }
+        } else {
+            aggregate.count = result[0][0].as<size_t>();
+            if (mode == OutputMode::BoundingBox && aggregate.count > 0) {
+                aggregate.bounding_box = Rectangle(result[0][1].as<double>(), result[0][2].as<double>(),
+                                                   result[0][3].as<double>(), result[0][4].as<double>());
+            }
+        }
+        
+        return aggregate;
+        
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Aggregate query execution failed: " + std::string(e.what()));
+    }
+}
+
+bool DatabaseManager::resolveConstraintGroups(
+    const Rectangle& valid_region,
+    const std::optional<bool>& proper_constraint,
+    std::vector<long long>& constraint_groups
+) {
+    constraint_groups.clear();
+    
+    // When proper_constraint is nullopt, constraint_groups remains empty and is ignored
+    if (!proper_constraint.has_value()) {
+        return true;
+    }
+    
+    // Only use valid_region when proper constraint is specified
+    std::vector<long long> proper_groups = getProperGroups(valid_region);
+    
+    if (proper_constraint.value()) {
+        // proper: true - only proper groups
+        constraint_groups = std::move(proper_groups);
+    } else {
+        // proper: false - only improper groups
+        // Get all groups and subtract proper groups
+        constraint_groups = getImproperGroups(valid_region, proper_groups);
+    }
+    
+    return !constraint_groups.empty();
+}
+
+std::string DatabaseManager::explainCropQuery(
+    const Rectangle& crop_region,
+    const Rectangle& valid_region,
+    const std::vector<int>& category_filter,
+    const std::vector<long long>& group_filter,
+    const std::optional<bool>& proper_constraint,
+    std::optional<size_t> limit,
+    const std::optional<KeysetCursor>& after
+) {
+    std::vector<long long> constraint_groups;
+    if (!resolveConstraintGroups(valid_region, proper_constraint, constraint_groups)) {
+        return "(no group satisfies the proper constraint; the crop query is skipped)";
+    }
+    
+    std::string query;
+    std::vector<long long> branch_groups;
+    if (selectGroupBranches(crop_region, group_filter, constraint_groups, branch_groups)) {
+        if (branch_groups.empty()) {
+            return "(no listed group's extent meets the crop; the crop query is skipped)";
+        }
+        query = buildGroupCropQuery(crop_region, category_filter, branch_groups, limit, after);
+    } else {
+        query = buildCropQuery(crop_region, category_filter, group_filter, constraint_groups, limit, after);
+    }
+    
+    try {
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+        pqxx::result result = txn.exec("EXPLAIN (ANALYZE, BUFFERS) " + query);
+        txn.commit();
+        
+        std::ostringstream plan;
+        for (const auto& row : result) {
+            plan << row[0].as<std::string>() << "\n";
+        }
+        return plan.str();
+        
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Explain failed: " + std::string(e.what()));
+    }
+}
+
+void DatabaseManager::detectCropIndexes() {
+    try {
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+        pqxx::result result = txn.exec(
+            "SELECT indexname FROM pg_indexes "
+            "WHERE tablename = 'inspection_region' AND indexname LIKE 'idx_crop_%'");
+        txn.commit();
+        
+        CropIndexInfo detected;
+        const std::string category_prefix = "idx_crop_cat_";
+        
+        for (const auto& row : result) {
+            std::string name = row[0].as<std::string>();
+            if (name == "idx_crop_covering") {
+                detected.covering = true;
+            } else if (name == "idx_crop_group") {
+                detected.groups = true;
+            } else if (name.compare(0, category_prefix.size(), category_prefix) == 0) {
+                // Negative categories are spelled with an 'm' instead of the minus sign (idx_crop_cat_m3 = -3)
+                std::string suffix = name.substr(category_prefix.size());
+                bool negative = !suffix.empty() && suffix[0] == 'm';
+                std::string digits = negative ? suffix.substr(1) : suffix;
+                try {
+                    size_t used = 0;
+                    int category = std::stoi(digits, &used);
+                    if (used == digits.size() && !digits.empty() && digits[0] != '-' && digits[0] != '+') {
+                        detected.partial_categories.insert(negative ? -category : category);
+                    }
+                } catch (const std::exception&) {
+                    // Not one of ours; ignore
+                }
+            }
+        }
+        
+        crop_indexes = std::move(detected);
+        
+        if (crop_indexes.covering || !crop_indexes.partial_categories.empty() || crop_indexes.groups) {
+            std::cout << "Crop indexes: covering=" << (crop_indexes.covering ? "yes" : "no")
+                      << ", partial categories=" << crop_indexes.partial_categories.size()
+                      << ", groups=" << (crop_indexes.groups ? "yes" : "no") << std::endl;
+        }
+        
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Index detection failed: " + std::string(e.what()));
+    }
+}
+
+void DatabaseManager::detectGroupExtent() {
+    try {
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+        pqxx::result result = txn.exec("SELECT to_regclass('group_extent') IS NOT NULL");
+        txn.commit();
+        
+        group_extent_available = result[0][0].as<bool>();
+        
+        if (!group_extent_available) {
+            std::cout << "Warning: group_extent table not found, proper checks aggregate all points "
+                      << "(recreate the schema to enable it)" << std::endl;
+        }
+        
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Group extent detection failed: " + std::string(e.what()));
+    }
+}
+
+void DatabaseManager::detectSpatialKeyGrid() {
+    try {
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+        pqxx::result exists = txn.exec("SELECT to_regclass('spatial_key_grid') IS NOT NULL");
+        
+        key_curve.reset();
+        if (exists[0][0].as<bool>()) {
+            pqxx::result grid = txn.exec(
+                "SELECT curve, key_order, min_x, min_y, max_x, max_y FROM spatial_key_grid WHERE id = 1");
+            if (!grid.empty()) {
+                Rectangle bounds(grid[0][2].as<double>(), grid[0][3].as<double>(),
+                                 grid[0][4].as<double>(), grid[0][5].as<double>());
+                key_curve.emplace(parseCurveType(grid[0][0].as<std::string>()), bounds, grid[0][1].as<int>());
+                std::cout << "Spatial key grid: " << grid[0][0].as<std::string>()
+                          << ", order " << key_curve->getOrder() << std::endl;
+            }
+        }
+        txn.commit();
+        
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Spatial key grid detection failed: " + std::string(e.what()));
+    }
+}
+
+const char* DatabaseManager::properGroupsQuery() const {
+    return group_extent_available ? PROPER_GROUPS_QUERY : PROPER_GROUPS_SCAN_QUERY;
+}
+
+const char* DatabaseManager::allGroupsQuery() const {
+    return group_extent_available ? ALL_GROUPS_QUERY : ALL_GROUPS_SCAN_QUERY;
+}
+
+std::vector<std::vector<Point>> DatabaseManager::executeCropQueryBatch(const std::vector<CropRequest>& requests) {
+    std::vector<std::vector<Point>> results(requests.size());
+    if (requests.empty()) {
+        return results;
+    }
+    
+    std::lock_guard<std::mutex> lock(pipeline_mutex);
+    
+    try {
+        if (!pipeline) {
+            pipeline = std::make_unique<PipelineConnection>(connection_string);
+        }
+        
+        // Round trip 1: proper groups for each distinct valid region that needs them
+        std::vector<Rectangle> valid_regions;
+        std::vector<size_t> region_of_request(requests.size(), 0);
+        bool need_all_groups = false;
+        
+        for (size_t i = 0; i < requests.size(); ++i) {
+            const CropRequest& request = requests[i];
+            if (!request.proper_constraint.has_value()) {
+                continue;
+            }
+            
+            auto it = std::find_if(valid_regions.begin(), valid_regions.end(), [&](const Rectangle& r) {
+                return sameRectangle(r, request.valid_region);
+            });
+            region_of_request[i] = static_cast<size_t>(it - valid_regions.begin());
+            if (it == valid_regions.end()) {
+                valid_regions.push_back(request.valid_region);
+            }
+            need_all_groups = need_all_groups || !request.proper_constraint.value();
+        }
+        
+        std::vector<PipelineStatement> group_statements;
+        for (const Rectangle& region : valid_regions) {
+            group_statements.emplace_back(properGroupsQuery(), std::vector<std::string>{
+                formatDouble(region.p_min.x), formatDouble(region.p_max.x),
+                formatDouble(region.p_min.y), formatDouble(region.p_max.y)});
+        }
+        if (need_all_groups) {
+            group_statements.emplace_back(allGroupsQuery());
+        }
+        
+        std::vector<PipelineResult> group_results = pipeline->execute(group_statements);
+        
+        auto readGroups = [](const PipelineResult& result) {
+            std::vector<long long> groups;
+            groups.reserve(result.size());
+            for (size_t row = 0; row < result.size(); ++row) {
+                groups.push_back(result.asLongLong(row, 0));
+            }
+            return groups;
+        };
+        
+        std::vector<std::vector<long long>> proper_groups_by_region;
+        for (size_t r = 0; r < valid_regions.size(); ++r) {
+            proper_groups_by_region.push_back(readGroups(group_results[r]));
+        }
+        std::vector<long long> all_groups;
+        if (need_all_groups) {
+            all_groups = readGroups(group_results.back());
+        }
+        
+        // Round trip 2: all crop statements; requests with no admissible group stay empty
+        std::vector<PipelineStatement> crop_statements;
+        std::vector<size_t> request_of_statement;
+        
+        for (size_t i = 0; i < requests.size(); ++i) {
+            const CropRequest& request = requests[i];
+            std::vector<long long> constraint_groups;
+            
+            if (request.proper_constraint.has_value()) {
+                const auto& proper_groups = proper_groups_by_region[region_of_request[i]];
+                constraint_groups = request.proper_constraint.value()
+                    ? proper_groups
+                    : subtractGroups(all_groups, proper_groups);
+                if (constraint_groups.empty()) {
+                    continue;
+                }
+            }
+            
+            crop_statements.emplace_back(buildCropQuery(request.crop_region, request.category_filter,
+                                                        request.group_filter, constraint_groups,
+                                                        request.limit, request.after));
+            request_of_statement.push_back(i);
+        }
+        
+        std::vector<PipelineResult> crop_results = pipeline->execute(crop_statements);
+        
+        for (size_t s = 0; s < crop_results.size(); ++s) {
+            const PipelineResult& result = crop_results[s];
+            std::vector<Point>& points = results[request_of_statement[s]];
+            
+            points.reserve(result.size());
+            for (size_t row = 0; row < result.size(); ++row) {
+                points.push_back(pipelineRowToPoint(result, row));
+            }
+            
+            // Sort by (y, x) as required
+            sortPoints(points);
+        }
+        
+        return results;
+        
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Batch query execution failed: " + std::string(e.what()));
+    }
+}
+
 std::vector<long long> DatabaseManager::getProperGroups(const Rectangle& valid_region) {
     try {
+        auto connection = pool->acquire();
         pqxx::work txn(*connection);
         
         // Find groups where ALL points are within valid_region
-        std::string query = R"(
-            SELECT group_id 
-            FROM inspection_region 
-            GROUP BY group_id 
-            HAVING MIN(coord_x) >= $1 AND MAX(coord_x) <= $2 
-               AND MIN(coord_y) >= $3 AND MAX(coord_y) <= $4
-        )";
-        
-        pqxx::result result = txn.exec_params(query,
+        pqxx::result result = txn.exec_params(properGroupsQuery(),
             valid_region.p_min.x, valid_region.p_max.x,
             valid_region.p_min.y, valid_region.p_max.y);
         txn.commit();
@@ -128,11 +666,11 @@ std::vector<long long> DatabaseManager::getProperGroups(const Rectangle& valid_r
 
 std::vector<long long> DatabaseManager::getImproperGroups(const Rectangle& valid_region, const std::vector<long long>& proper_groups) {
     try {
+        auto connection = pool->acquire();
         pqxx::work txn(*connection);
         
         // Find all unique groups, then subtract proper groups
-        std::string query = "SELECT DISTINCT group_id FROM inspection_region";
-        pqxx::result result = txn.exec(query);
+        pqxx::result result = txn.exec(allGroupsQuery());
         txn.commit();
         
         std::vector<long long> all_groups;
@@ -143,14 +681,7 @@ std::vector<long long> DatabaseManager::getImproperGroups(const Rectangle& valid
         }
         
         // Remove proper groups to get improper groups
-        std::vector<long long> improper_groups;
-        for (long long group_id : all_groups) {
-            if (std::find(proper_groups.begin(), proper_groups.end(), group_id) == proper_groups.end()) {
-                improper_groups.push_back(group_id);
-            }
-        }
-        
-        return improper_groups;
+        return subtractGroups(all_groups, proper_groups);
         
     } catch (const std::exception& e) {
         throw std::runtime_error("Improper groups query failed: " + std::string(e.what()));
@@ -159,6 +690,7 @@ std::vector<long long> DatabaseManager::getImproperGroups(const Rectangle& valid
 
 size_t DatabaseManager::getTableCount(const std::string& table_name) {
     try {
+        auto connection = pool->acquire();
         pqxx::work txn(*connection);
         pqxx::result result = txn.exec("SELECT COUNT(*) FROM " + table_name);
         txn.commit();
@@ -173,30 +705,172 @@ std::string DatabaseManager::buildCropQuery(
     const Rectangle& crop_region,
     const std::vector<int>& category_filter,
     const std::vector<long long>& group_filter,
-    const std::vector<long long>& proper_groups
+    const std::vector<long long>& proper_groups,
+    std::optional<size_t> limit,
+    const std::optional<KeysetCursor>& after
 ) {
     std::ostringstream query;
+    const char* select_rows = "SELECT id, coord_x, coord_y, group_id, category FROM inspection_region WHERE ";
     
-    query << "SELECT id, coord_x, coord_y, group_id, category "
-          << "FROM inspection_region WHERE ";
+    std::string keyset_condition = keysetCondition(after);
     
+    // Every listed category has its own partial index: one ordered branch per category
+    bool per_category_branches = category_filter.size() > 1 &&
+        std::all_of(category_filter.begin(), category_filter.end(), [this](int category) {
+            return crop_indexes.partial_categories.count(category) > 0;
+        });
+    
+    if (per_category_branches) {
+        query << "SELECT id, coord_x, coord_y, group_id, category FROM (";
+        for (size_t i = 0; i < category_filter.size(); ++i) {
+            if (i > 0) query << " UNION ALL ";
+            query << select_rows
+                  << buildCropConditions(crop_region, {category_filter[i]}, group_filter, proper_groups)
+                  << keyset_condition;
+        }
+        query << ") AS per_category";
+    } else {
+        query << select_rows
+              << buildCropConditions(crop_region, category_filter, group_filter, proper_groups)
+              << keyset_condition;
+    }
+    
+    // Order by (y, x), id makes the order total so pages never overlap
+    query << " ORDER BY coord_y, coord_x, id";
+    
+    if (limit.has_value()) {
+        query << " LIMIT " << limit.value();
+    }
+    
+    return query.str();
+}
+
+bool DatabaseManager::selectGroupBranches(
+    const Rectangle& crop_region,
+    const std::vector<long long>& group_filter,
+    const std::vector<long long>& constraint_groups,
+    std::vector<long long>& branch_groups
+) {
+    branch_groups.clear();
+    if (group_filter.empty() || !crop_indexes.groups || !group_extent_available) {
+        return false;
+    }
+    
+    // Listed groups that the proper constraint admits
+    std::unordered_set<long long> admissible(constraint_groups.begin(), constraint_groups.end());
+    std::set<long long> listed;
+    for (long long group_id : group_filter) {
+        if (admissible.empty() || admissible.count(group_id) > 0) {
+            listed.insert(group_id);
+        }
+    }
+    if (listed.size() > GROUP_BRANCH_MAX_GROUPS) {
+        return false;
+    }
+    if (listed.empty()) {
+        return true;
+    }
+    
+    std::ostringstream ids;
+    ids << "{";
+    for (auto it = listed.begin(); it != listed.end(); ++it) {
+        if (it != listed.begin()) ids << ",";
+        ids << *it;
+    }
+    ids << "}";
+    
+    try {
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+        pqxx::result result = txn.exec_params(LISTED_GROUP_EXTENTS_QUERY, ids.str());
+        txn.commit();
+        
+        size_t total_points = 0;
+        for (const auto& row : result) {
+            total_points += row[5].as<size_t>();
+            if (total_points > GROUP_BRANCH_MAX_ROWS) {
+                return false;
+            }
+            
+            // Empty groups have no extent; groups whose extent misses the crop cannot contribute
+            if (row[1].is_null()) {
+                continue;
+            }
+            Rectangle extent(row[1].as<double>(), row[2].as<double>(), row[3].as<double>(), row[4].as<double>());
+            if (extent.intersects(crop_region)) {
+                branch_groups.push_back(row[0].as<long long>());
+            }
+        }
+        return true;
+        
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Group extent lookup failed: " + std::string(e.what()));
+    }
+}
+
+std::string DatabaseManager::buildGroupCropQuery(
+    const Rectangle& crop_region,
+    const std::vector<int>& category_filter,
+    const std::vector<long long>& branch_groups,
+    std::optional<size_t> limit,
+    const std::optional<KeysetCursor>& after
+) {
+    std::ostringstream query;
+    std::string keyset_condition = keysetCondition(after);
+    
+    query << "SELECT id, coord_x, coord_y, group_id, category FROM (";
+    for (size_t i = 0; i < branch_groups.size(); ++i) {
+        if (i > 0) query << " UNION ALL ";
+        query << "SELECT id, coord_x, coord_y, group_id, category FROM inspection_region WHERE "
+              << buildCropConditions(crop_region, category_filter, {branch_groups[i]}, {})
+              << keyset_condition;
+    }
+    query << ") AS per_group ORDER BY coord_y, coord_x, id";
+    
+    if (limit.has_value()) {
+        query << " LIMIT " << limit.value();
+    }
+    
+    return query.str();
+}
+
+std::string DatabaseManager::buildCropConditions(
+    const Rectangle& crop_region,
+    const std::vector<int>& category_filter,
+    const std::vector<long long>& group_filter,
+    const std::vector<long long>& proper_groups
+) {
     std::vector<std::string> conditions;
     
-    // Crop region condition
-    conditions.push_back("coord_x >= " + std::to_string(crop_region.p_min.x));
-    conditions.push_back("coord_x <= " + std::to_string(crop_region.p_max.x));
-    conditions.push_back("coord_y >= " + std::to_string(crop_region.p_min.y));
-    conditions.push_back("coord_y <= " + std::to_string(crop_region.p_max.y));
+    // Crop region condition (full precision, so boundary points match the in-memory check)
+    conditions.push_back("coord_x >= " + formatDouble(crop_region.p_min.x));
+    conditions.push_back("coord_x <= " + formatDouble(crop_region.p_max.x));
+    conditions.push_back("coord_y >= " + formatDouble(crop_region.p_min.y));
+    conditions.push_back("coord_y <= " + formatDouble(crop_region.p_max.y));
+    
+    // Morton key ranges covering the rectangle; the exact bounds above remove false positives.
+    // Rows without a key (written outside the loader, or moved since) are always candidates.
+    if (morton_ranges > 0 && key_curve) {
+        std::ostringstream key_condition;
+        for (const auto& range : key_curve->decompose(crop_region, morton_ranges)) {
+            key_condition << "morton_key BETWEEN " << range.first << " AND " << range.last << " OR ";
+        }
+        key_condition << "morton_key IS NULL";
+        conditions.push_back(key_condition.str());
+    }
     
-    // Category filter
-    if (!category_filter.empty()) {
+    // Category filter: a single category keeps the plain equality partial indexes are declared with,
+    // a list is one array comparison instead of an OR chain
+    if (category_filter.size() == 1) {
+        conditions.push_back("category = " + std::to_string(category_filter[0]));
+    } else if (!category_filter.empty()) {
         std::ostringstream cat_condition;
-        cat_condition << "category IN (";
+        cat_condition << "category = ANY(ARRAY[";
         for (size_t i = 0; i < category_filter.size(); ++i) {
             if (i > 0) cat_condition << ", ";
             cat_condition << category_filter[i];
         }
-        cat_condition << ")";
+        cat_condition << "])";
         conditions.push_back(cat_condition.str());
     }
     
@@ -225,15 +899,13 @@ std::string DatabaseManager::buildCropQuery(
     }
     
     // Combine conditions
+    std::ostringstream where;
     for (size_t i = 0; i < conditions.size(); ++i) {
-        if (i > 0) query << " AND ";
-        query << "(" << conditions[i] << ")";
+        if (i > 0) where << " AND ";
+        where << "(" << conditions[i] << ")";
     }
     
-    // Order by (y, x)
-    query << " ORDER BY coord_y, coord_x";
-    
-    return query.str();
+    return where.str();
 }
 
 Point DatabaseManager::resultToPoint(const pqxx::row& row) {
@@ -246,13 +918,114 @@ Point DatabaseManager::resultToPoint(const pqxx::row& row) {
     );
 }
 
+Point DatabaseManager::pipelineRowToPoint(const PipelineResult& result, size_t row) {
+    // Column order matches buildCropQuery: id, coord_x, coord_y, group_id, category
+    return Point(
+        result.asDouble(row, 1),
+        result.asDouble(row, 2),
+        result.asLongLong(row, 0),
+        result.asLongLong(row, 3),
+        result.asInt(row, 4)
+    );
+}
+
+std::vector<long long> DatabaseManager::subtractGroups(const std::vector<long long>& all_groups,
+                                                       const std::vector<long long>& proper_groups) {
+    std::unordered_set<long long> proper_set(proper_groups.begin(), proper_groups.end());
+    
+    std::vector<long long> remaining;
+    for (long long group_id : all_groups) {
+        if (proper_set.find(group_id) == proper_set.end()) {
+            remaining.push_back(group_id);
+        }
+    }
+    
+    return remaining;
+}
+
+std::optional<std::vector<long long>> DatabaseManager::getGroupsReaching(
+    const Rectangle& crop_region,
+    const std::optional<Rectangle>& within,
+    const std::vector<long long>& group_filter
+) {
+    if (!group_extent_available) {
+        return std::nullopt;
+    }
+    
+    // Box overlap uses idx_group_extent_box; it is slightly fuzzy (EPSILON), so the exact comparisons follow.
+    // Empty groups have NULL bounds and never match.
+    std::ostringstream query;
+    query << "SELECT group_id FROM group_extent WHERE box(point(min_x, min_y), point(max_x, max_y)) && box(point("
+          << formatDouble(crop_region.p_min.x) << ", " << formatDouble(crop_region.p_min.y) << "), point("
+          << formatDouble(crop_region.p_max.x) << ", " << formatDouble(crop_region.p_max.y) << "))"
+          << " AND min_x <= " << formatDouble(crop_region.p_max.x) << " AND max_x >= " << formatDouble(crop_region.p_min.x)
+          << " AND min_y <= " << formatDouble(crop_region.p_max.y) << " AND max_y >= " << formatDouble(crop_region.p_min.y);
+    if (within) {
+        query << " AND min_x >= " << formatDouble(within->p_min.x) << " AND max_x <= " << formatDouble(within->p_max.x)
+              << " AND min_y >= " << formatDouble(within->p_min.y) << " AND max_y <= " << formatDouble(within->p_max.y);
+    }
+    if (group_filter.empty()) {
+        query << " LIMIT 1";
+    } else {
+        query << " AND group_id = ANY(ARRAY[";
+        for (size_t i = 0; i < group_filter.size(); ++i) {
+            if (i > 0) query << ", ";
+            query << group_filter[i];
+        }
+        query << "]::bigint[])";
+    }
+    
+    try {
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+        pqxx::result result = txn.exec(query.str());
+        txn.commit();
+        
+        std::vector<long long> groups;
+        groups.reserve(result.size());
+        for (const auto& row : result) {
+            groups.push_back(row[0].as<long long>());
+        }
+        return groups;
+        
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Group extent lookup failed: " + std::string(e.what()));
+    }
+}
+
+std::vector<GroupExtent> DatabaseManager::getGroupExtents() {
+    try {
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+        pqxx::result result = txn.exec(group_extent_available ? GROUP_EXTENTS_QUERY : GROUP_EXTENTS_SCAN_QUERY);
+        txn.commit();
+        
+        std::vector<GroupExtent> extents;
+        extents.reserve(result.size());
+        
+        for (const auto& row : result) {
+            extents.push_back({
+                row[0].as<long long>(),
+                Rectangle(row[1].as<double>(), row[2].as<double>(), row[3].as<double>(), row[4].as<double>()),
+                row[5].as<size_t>()
+            });
+        }
+        
+        return extents;
+        
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Group extents query failed: " + std::string(e.what()));
+    }
+}
+
 std::vector<Point> DatabaseManager::getAllPoints() {
     std::vector<Point> points;
     
     try {
+        auto connection = pool->acquire();
         pqxx::work txn(*connection);
         
-        std::string query = "SELECT id, coord_x, coord_y, group_id, category FROM inspection_region ORDER BY coord_y, coord_x";
+        std::string query = "SELECT id, coord_x, coord_y, group_id, category FROM inspection_region ORDER BY coord_y, coord_x, id";
         pqxx::result result = txn.exec(query);
         
         points.reserve(result.size());
@@ -4,27 +4,76 @@
 #include <string>
 #include <vector>
 #include <optional>
+#include <mutex>
+#include <set>
 #include <pqxx/pqxx>
+#include "ConnectionPool.h"
+#include "PipelineConnection.h"
 #include "../geometry/Point.h"
 #include "../geometry/Rectangle.h"
+#include "../geometry/SpaceFillingCurve.h"
+#include "../query/AggregateResult.h"
+#include "../query/CropRequest.h"
+
+/**
+ * Optional crop indexes present in the schema (solution 1 indexes_covering.sql)
+ */
+struct CropIndexInfo {
+    bool covering = false;             // idx_crop_covering: (coord_y, coord_x, id) INCLUDE (group_id, category)
+    std::set<int> partial_categories;  // idx_crop_cat_<n> (m<n> for -n): same shape, WHERE category = n
+    bool groups = false;               // idx_crop_group: (group_id, coord_y, coord_x, id) INCLUDE (category)
+};
+
+/**
+ * Bounding box and size of one group's points
+ */
+struct GroupExtent {
+    long long group_id;
+    Rectangle bounds;
+    size_t point_count;
+};
 
 /**
  * Database manager for spatial queries on inspection regions
+ *
+ * All query methods check out their own connection from the pool, so a single
+ * DatabaseManager can be shared by several threads.
  */
 class DatabaseManager {
 private:
-    std::unique_ptr<pqxx::connection> connection;
+    std::unique_ptr<ConnectionPool> pool;
     std::string connection_string;
+    
+    // Optional crop indexes, detected at startup; selects the SQL shape of crop queries
+    CropIndexInfo crop_indexes;
+    
+    // Whether the trigger-maintained group_extent table exists (otherwise proper checks scan all points)
+    bool group_extent_available = false;
+    
+    // Grid of the loader-written morton_key column (from spatial_key_grid), if present
+    std::optional<SpaceFillingCurve> key_curve;
+    
+    // Maximum morton_key ranges per crop; 0 leaves the spatial predicate to the other indexes
+    size_t morton_ranges = 0;
+    
+    // Large crops are split into up to this many y-bands run on separate connections (1 = off)
+    size_t parallel_bands = 1;
+    size_t parallel_min_rows = 50000;
+    
+    // Separate libpq connection for pipelined batches, opened on first use
+    std::unique_ptr<PipelineConnection> pipeline;
+    std::mutex pipeline_mutex;
 
 public:
     /**
-     * Initialize database connection
+     * Initialize the connection pool and open the first connection
      * @param conn_str PostgreSQL connection string
+     * @param pool_size Maximum number of concurrent connections (further ones are opened lazily)
      */
-    explicit DatabaseManager(const std::string& conn_str);
+    explicit DatabaseManager(const std::string& conn_str, size_t pool_size = 4);
     
     /**
-     * Destructor - ensures connection is properly closed
+     * Destructor - ensures all pooled connections are properly closed
      */
     ~DatabaseManager();
     
@@ -41,18 +90,54 @@ public:
      * @param category_filter Optional category ID filter (empty if no filter)
      * @param group_filter Optional list of group IDs to include (empty if no filter)
      * @param proper_constraint Optional proper flag: true=proper groups, false=improper groups, nullopt=ignore
-     * @return Vector of points matching all criteria, sorted by (y, x)
+     * @param limit Optional maximum number of points (first N in (y, x, id) order)
+     * @param after Optional keyset cursor: only points strictly after it in (y, x, id) order
+     * @return Vector of points matching all criteria, sorted by (y, x, id)
      */
     std::vector<Point> executeCropQuery(
         const Rectangle& crop_region,
         const Rectangle& valid_region,
         const std::vector<int>& category_filter = {},
         const std::vector<long long>& group_filter = {},
+        const std::optional<bool>& proper_constraint = std::nullopt,
+        std::optional<size_t> limit = std::nullopt,
+        const std::optional<KeysetCursor>& after = std::nullopt
+    );
+    
+    /**
+     * Execute a crop query as a SQL aggregate without fetching the matching rows
+     * @param crop_region Rectangle to crop points from
+     * @param valid_region Rectangle defining valid bounds for proper groups
+     * @param mode Aggregate to compute (any mode except OutputMode::Points)
+     * @param category_filter Optional category ID filter (empty if no filter)
+     * @param group_filter Optional list of group IDs to include (empty if no filter)
+     * @param proper_constraint Optional proper flag: true=proper groups, false=improper groups, nullopt=ignore
+     * @return Count, per-category/per-group counts or bounding box of the matching points
+     */
+    AggregateResult executeAggregateQuery(
+        const Rectangle& crop_region,
+        const Rectangle& valid_region,
+        OutputMode mode,
+        const std::vector<int>& category_filter = {},
+        const std::vector<long long>& group_filter = {},
         const std::optional<bool>& proper_constraint = std::nullopt
     );
     
+    /**
+     * Execute many crop queries through libpq pipeline mode
+     * 
+     * Proper-group lookups for all distinct valid regions go out in one pipeline,
+     * then all crop statements in a second one, so the batch costs two network
+     * round trips regardless of its size.
+     * @param requests Crop queries to execute
+     * @return One result per request, in request order, each sorted by (y, x)
+     */
+    std::vector<std::vector<Point>> executeCropQueryBatch(const std::vector<CropRequest>& requests);
+    
     /**
      * Get all groups that are entirely within the valid region
+     * Reads one row per group from group_extent via its box index, so the cost
+     * does not depend on the number of points
      * @param valid_region Rectangle defining valid bounds
      * @return Vector of group IDs that are proper (all points in valid region)
      */
@@ -73,25 +158,215 @@ public:
      */
     size_t getTableCount(const std::string& table_name);
     
+    /**
+     * Get the bounding box of every group that has points
+     * @return One extent per non-empty group
+     */
+    std::vector<GroupExtent> getGroupExtents();
+    
+    /**
+     * Groups whose extent reaches into a crop, read from group_extent via its box index
+     * group_extent is maintained by triggers, so the answer reflects every committed change.
+     * @param crop_region Crop rectangle
+     * @param within If given, only groups lying entirely inside it (proper: true)
+     * @param group_filter Only these groups; when empty, any group and at most one is returned
+     * @return Group ids, or nullopt when there is no group_extent table (no group can be ruled out)
+     */
+    std::optional<std::vector<long long>> getGroupsReaching(
+        const Rectangle& crop_region,
+        const std::optional<Rectangle>& within,
+        const std::vector<long long>& group_filter
+    );
+    
     /**
      * Load all points from database for testing purposes
      * @return Vector of all points in the database
      */
     std::vector<Point> getAllPoints();
     
+    /**
+     * Explain a crop query as the database would execute it
+     * @return EXPLAIN (ANALYZE, BUFFERS) output, showing the chosen indexes and buffers touched
+     */
+    std::string explainCropQuery(
+        const Rectangle& crop_region,
+        const Rectangle& valid_region,
+        const std::vector<int>& category_filter = {},
+        const std::vector<long long>& group_filter = {},
+        const std::optional<bool>& proper_constraint = std::nullopt,
+        std::optional<size_t> limit = std::nullopt,
+        const std::optional<KeysetCursor>& after = std::nullopt
+    );
+    
+    /**
+     * Re-detect the optional covering / partial crop indexes (call after creating or dropping them)
+     */
+    void detectCropIndexes();
+    
+    /**
+     * Get the optional crop indexes found in the schema
+     */
+    const CropIndexInfo& getCropIndexes() const { return crop_indexes; }
+    
+    /**
+     * Serve crop rectangles through btree range scans on morton_key
+     * More ranges hug the rectangle more tightly (fewer false positives for the
+     * exact filter) at the cost of more index scans per statement. Has no effect
+     * unless the loader wrote Morton keys. Call before issuing queries.
+     * @param max_ranges Maximum ranges per crop (0 disables the Morton predicate)
+     */
+    void setMortonKeyRanges(size_t max_ranges) { morton_ranges = max_ranges; }
+    
+    /**
+     * Split large crops into horizontal y-bands executed in parallel
+     * Each band runs on its own pooled connection; all bands import one exported
+     * snapshot, so together they see exactly what a single statement would. Bands
+     * come back in y order and are concatenated without a global sort. Crops with
+     * a limit are never split. Call before issuing queries.
+     * @param max_bands Maximum number of bands (capped at the pool size; 1 disables splitting)
+     * @param min_rows Only split crops the planner estimates at this many rows or more
+     */
+    void setParallelBands(size_t max_bands, size_t min_rows = 50000) {
+        parallel_bands = max_bands;
+        parallel_min_rows = min_rows;
+    }
+    
+    /**
+     * Check whether the data has Morton keys (spatial_key_grid is populated)
+     */
+    bool hasMortonKeys() const { return key_curve.has_value(); }
+    
+    /**
+     * Get the connection pool (for callers that need their own transactions)
+     */
+    ConnectionPool& getPool() { return *pool; }
+    
 private:
+    /**
+     * Check whether the group_extent table exists
+     */
+    void detectGroupExtent();
+    
+    /**
+     * Load the Morton key grid written by the data loader, if any
+     */
+    void detectSpatialKeyGrid();
+    
+    /**
+     * SQL for proper groups / all groups: group_extent lookups, or full aggregation without it
+     */
+    const char* properGroupsQuery() const;
+    const char* allGroupsQuery() const;
+    
     /**
      * Build SQL query for crop operation
+     * The optional keyset cursor and limit compile to a (coord_y, coord_x, id) row
+     * comparison and LIMIT, served in order by idx_sort / idx_crop_covering.
+     * A multi-category filter whose categories all have partial indexes becomes a
+     * UNION ALL of per-category branches, merged in order from index-only scans.
      */
     std::string buildCropQuery(
         const Rectangle& crop_region,
         const std::vector<int>& category_filter,
         const std::vector<long long>& group_filter,
-        const std::vector<long long>& proper_groups = {}
+        const std::vector<long long>& proper_groups = {},
+        std::optional<size_t> limit = std::nullopt,
+        const std::optional<KeysetCursor>& after = std::nullopt
     );
     
+    /**
+     * Decide whether a group-filtered crop reads its groups one by one through idx_crop_group
+     * 
+     * That index holds every group as a contiguous slice in (y, x, id) order, so
+     * a crop over a few small groups is one short range scan per group, merged
+     * in order, instead of a scan of the crop's band across all groups. Chosen
+     * when group_extent says the listed groups (narrowed to the admissible ones)
+     * hold at most GROUP_BRANCH_MAX_ROWS points; groups whose extent misses the
+     * crop get no branch.
+     * @param constraint_groups Admissible groups from the proper constraint (empty = all)
+     * @param branch_groups Output: groups to read (may be empty: no group can match)
+     * @return true if the crop should be read group by group
+     */
+    bool selectGroupBranches(
+        const Rectangle& crop_region,
+        const std::vector<long long>& group_filter,
+        const std::vector<long long>& constraint_groups,
+        std::vector<long long>& branch_groups
+    );
+    
+    /**
+     * Build SQL for a crop read group by group: a UNION ALL of one branch per group
+     * Each branch is an ordered range scan of idx_crop_group; the database merges
+     * the branches in (y, x, id) order, so a limit stops all of them early.
+     */
+    std::string buildGroupCropQuery(
+        const Rectangle& crop_region,
+        const std::vector<int>& category_filter,
+        const std::vector<long long>& branch_groups,
+        std::optional<size_t> limit,
+        const std::optional<KeysetCursor>& after
+    );
+    
+    /**
+     * Build the WHERE clause shared by row and aggregate crop queries
+     */
+    std::string buildCropConditions(
+        const Rectangle& crop_region,
+        const std::vector<int>& category_filter,
+        const std::vector<long long>& group_filter,
+        const std::vector<long long>& proper_groups
+    );
+    
+    /**
+     * Resolve the proper constraint into the list of admissible groups
+     * @param constraint_groups Output: admissible groups (left empty when there is no constraint)
+     * @return false if a constraint is given but no group satisfies it (the query result is empty)
+     */
+    bool resolveConstraintGroups(
+        const Rectangle& valid_region,
+        const std::optional<bool>& proper_constraint,
+        std::vector<long long>& constraint_groups
+    );
+    
+    /**
+     * Run a crop as parallel y-bands sharing one snapshot
+     * Runs fewer bands (down to one statement) when the pool cannot hand out enough connections at once.
+     * @param bands Number of bands wanted (>= 2)
+     * @return Points of all bands, sorted by (y, x, id)
+     */
+    std::vector<Point> executeBandedCropQuery(
+        const Rectangle& crop_region,
+        const std::vector<int>& category_filter,
+        const std::vector<long long>& group_filter,
+        const std::vector<long long>& constraint_groups,
+        const std::optional<KeysetCursor>& after,
+        size_t bands
+    );
+    
+    /**
+     * Planner row estimate of a query (EXPLAIN without running it)
+     */
+    double estimateRows(const std::string& query);
+    
+    /**
+     * Split a rectangle into horizontal bands of equal height that do not overlap:
+     * every band except the last ends just below the next band's lower edge
+     */
+    static std::vector<Rectangle> splitIntoBands(const Rectangle& region, size_t bands);
+    
     /**
      * Convert pqxx result row to Point object
      */
     Point resultToPoint(const pqxx::row& row);
+    
+    /**
+     * Convert row of a pipelined crop query result to Point object
+     */
+    static Point pipelineRowToPoint(const PipelineResult& result, size_t row);
+    
+    /**
+     * Groups in all_groups that are not in proper_groups
+     */
+    static std::vector<long long> subtractGroups(const std::vector<long long>& all_groups,
+                                                 const std::vector<long long>& proper_groups);
 };
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "PipelineConnection.h"
+#include <cstdlib>
+#include <stdexcept>
+#include <poll.h>
+
+double PipelineResult::asDouble(size_t row, int column) const {
+    return std::strtod(value(row, column), nullptr);
+}
+
+long long PipelineResult::asLongLong(size_t row, int column) const {
+    return std::strtoll(value(row, column), nullptr, 10);
+}
+
+int PipelineResult::asInt(size_t row, int column) const {
+    return static_cast<int>(std::strtol(value(row, column), nullptr, 10));
+}
+
+PipelineConnection::PipelineConnection(const std::string& conn_str)
+    : connection(PQconnectdb(conn_str.c_str())) {
+    if (!connection || PQstatus(connection.get()) != CONNECTION_OK) {
+        throw std::runtime_error("Pipeline connection failed: " + errorMessage());
+    }
+}
+
+std::vector<PipelineResult> PipelineConnection::execute(const std::vector<PipelineStatement>& statements) {
+    std::vector<PipelineResult> results;
+    if (statements.empty()) {
+        return results;
+    }
+
+    ensureConnected();
+    PGconn* conn = connection.get();
+
+    // Non-blocking while sending, so a large batch cannot deadlock against the server's output
+    if (PQsetnonblocking(conn, 1) != 0 || PQenterPipelineMode(conn) != 1) {
+        throw std::runtime_error("Failed to enter pipeline mode: " + errorMessage());
+    }
+
+    std::string first_error;
+    try {
+        for (const auto& statement : statements) {
+            std::vector<const char*> values;
+            values.reserve(statement.params.size());
+            for (const auto& param : statement.params) {
+                values.push_back(param.c_str());
+            }
+
+            if (PQsendQueryParams(conn, statement.sql.c_str(), static_cast<int>(values.size()),
+                                  nullptr, values.empty() ? nullptr : values.data(),
+                                  nullptr, nullptr, 0) != 1) {
+                throw std::runtime_error("Failed to queue pipelined statement: " + errorMessage());
+            }
+            flushOutput();
+        }
+
+        if (PQpipelineSync(conn) != 1) {
+            throw std::runtime_error("Failed to send pipeline sync: " + errorMessage());
+        }
+        flushOutput();
+        PQsetnonblocking(conn, 0);
+
+        // Read results in order: each statement yields its result followed by a NULL separator
+        results.reserve(statements.size());
+
+        for (size_t i = 0; i < statements.size(); ++i) {
+            PGresult* res = PQgetResult(conn);
+            if (res == nullptr) {
+                throw std::runtime_error("Pipeline ended early after " + std::to_string(i) + " results");
+            }
+
+            ExecStatusType status = PQresultStatus(res);
+            if (status != PGRES_TUPLES_OK && status != PGRES_COMMAND_OK && first_error.empty()) {
+                first_error = status == PGRES_PIPELINE_ABORTED
+                    ? "statement " + std::to_string(i) + " aborted by earlier failure"
+                    : "statement " + std::to_string(i) + ": " + PQresultErrorMessage(res);
+            }
+            results.emplace_back(res);
+
+            while ((res = PQgetResult(conn)) != nullptr) {
+                PQclear(res);
+            }
+        }
+
+        // Consume the sync marker and leave pipeline mode
+        PGresult* sync = PQgetResult(conn);
+        if (sync != nullptr) {
+            PQclear(sync);
+        }
+        if (PQexitPipelineMode(conn) != 1) {
+            throw std::runtime_error("Failed to leave pipeline mode: " + errorMessage());
+        }
+    } catch (...) {
+        // Leftover pipeline state makes the connection unusable; start over next batch
+        PQsetnonblocking(conn, 0);
+        PQreset(conn);
+        throw;
+    }
+
+    if (!first_error.empty()) {
+        throw std::runtime_error("Pipelined query failed: " + first_error);
+    }
+
+    return results;
+}
+
+void PipelineConnection::ensureConnected() {
+    if (PQstatus(connection.get()) != CONNECTION_OK) {
+        PQreset(connection.get());
+        if (PQstatus(connection.get()) != CONNECTION_OK) {
+            throw std::runtime_error("Pipeline connection lost: " + errorMessage());
+        }
+    }
+}
+
+void PipelineConnection::flushOutput() {
+    PGconn* conn = connection.get();
+
+    while (true) {
+        int flushed = PQflush(conn);
+        if (flushed == 0) {
+            return;
+        }
+        if (flushed < 0) {
+            throw std::runtime_error("Failed to flush pipeline: " + errorMessage());
+        }
+
+        // Server is not accepting more yet: wait until we can write or must read
+        // (poll rather than select, which cannot take descriptors at or above FD_SETSIZE)
+        pollfd socket{PQsocket(conn), POLLIN | POLLOUT, 0};
+        if (poll(&socket, 1, -1) < 0) {
+            throw std::runtime_error("poll() failed while flushing pipeline");
+        }
+        if ((socket.revents & (POLLIN | POLLERR | POLLHUP)) != 0 && PQconsumeInput(conn) != 1) {
+            throw std::runtime_error("Failed to read from server: " + errorMessage());
+        }
+    }
+}
+
+std::string PipelineConnection::errorMessage() const {
+    return connection ? PQerrorMessage(connection.get()) : "out of memory";
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <libpq-fe.h>
+
+/**
+ * One statement sent through a pipeline (text-format parameters)
+ */
+struct PipelineStatement {
+    std::string sql;
+    std::vector<std::string> params;
+
+    PipelineStatement() = default;
+    explicit PipelineStatement(std::string query, std::vector<std::string> values = {})
+        : sql(std::move(query)), params(std::move(values)) {}
+};
+
+/**
+ * Owned result of one pipelined statement
+ */
+class PipelineResult {
+private:
+    struct ResultDeleter {
+        void operator()(PGresult* result) const { PQclear(result); }
+    };
+    std::unique_ptr<PGresult, ResultDeleter> result;
+
+public:
+    explicit PipelineResult(PGresult* res) : result(res) {}
+
+    size_t size() const { return result ? static_cast<size_t>(PQntuples(result.get())) : 0; }
+    bool empty() const { return size() == 0; }
+
+    const char* value(size_t row, int column) const { return PQgetvalue(result.get(), static_cast<int>(row), column); }
+    double asDouble(size_t row, int column) const;
+    long long asLongLong(size_t row, int column) const;
+    int asInt(size_t row, int column) const;
+};
+
+/**
+ * Dedicated libpq connection that executes statements in pipeline mode
+ *
+ * All statements of a batch are written to the socket before any result is
+ * read, so the whole batch costs one network round trip instead of one per
+ * statement. pqxx does not expose its PGconn, hence the separate connection.
+ * Not thread-safe; callers serialize access.
+ */
+class PipelineConnection {
+private:
+    struct ConnectionDeleter {
+        void operator()(PGconn* conn) const { PQfinish(conn); }
+    };
+    std::unique_ptr<PGconn, ConnectionDeleter> connection;
+
+public:
+    /**
+     * Open the connection
+     * @param conn_str PostgreSQL connection string (URI or key=value)
+     * @throws std::runtime_error if the connection cannot be established
+     */
+    explicit PipelineConnection(const std::string& conn_str);
+
+    /**
+     * Execute statements in a single pipeline
+     * @param statements Statements to send, in order
+     * @return One result per statement, in the same order
+     * @throws std::runtime_error if any statement fails (the rest of the batch is aborted by the server)
+     */
+    std::vector<PipelineResult> execute(const std::vector<PipelineStatement>& statements);
+
+private:
+    /**
+     * Reconnect if the server closed the connection since the last batch
+     */
+    void ensureConnected();
+
+    /**
+     * Flush pending output, reading incoming data meanwhile so neither side's buffers fill up
+     */
+    void flushOutput();
+
+    std::string errorMessage() const;
+};
\ No newline at end of file
@@ -0,0 +1,20 @@
+#include "CategoryMask.h"
+#include <algorithm>
+
+CategoryMask::CategoryMask(const std::vector<int>& categories) : values(categories) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    
+    for (int category : values) {
+        unsigned value = static_cast<unsigned>(category);
+        if (value < static_cast<unsigned>(DOMAIN_SIZE)) {
+            bits[value / 64] |= uint64_t(1) << (value % 64);
+        } else {
+            in_domain = false;
+        }
+    }
+}
+
+bool CategoryMask::containsOutside(int category) const {
+    return std::binary_search(values.begin(), values.end(), category);
+}
\ No newline at end of file
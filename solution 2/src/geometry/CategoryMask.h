@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+/**
+ * Set of allowed categories as a 256-bit membership mask
+ *
+ * Categories 0..DOMAIN_SIZE-1 are bits of four 64-bit words, so a point's category
+ * is tested with one shift and AND however many categories the filter lists
+ * (and the scan kernels test a whole vector of rows with one table lookup).
+ * A filter naming a category outside that range also keeps the sorted list,
+ * which is then searched for out-of-range values only.
+ */
+class CategoryMask {
+public:
+    static constexpr int DOMAIN_SIZE = 256;
+    
+    CategoryMask() = default;
+    
+    /**
+     * @param categories Allowed categories, in any order, duplicates allowed (empty = any category)
+     */
+    CategoryMask(const std::vector<int>& categories);
+    CategoryMask(std::initializer_list<int> categories) : CategoryMask(std::vector<int>(categories)) {}
+    
+    /**
+     * True when no category filter is set
+     */
+    bool empty() const { return values.empty(); }
+    
+    /**
+     * True when every allowed category lies in 0..DOMAIN_SIZE-1, so words() alone describes the set
+     */
+    bool inDomain() const { return in_domain; }
+    
+    bool contains(int category) const {
+        unsigned value = static_cast<unsigned>(category);
+        if (value < static_cast<unsigned>(DOMAIN_SIZE)) {
+            return (bits[value / 64] >> (value % 64) & 1) != 0;
+        }
+        return !in_domain && containsOutside(category);
+    }
+    
+    /**
+     * Mask words; bit c % 64 of word c / 64 is set when category c is allowed
+     */
+    const uint64_t* words() const { return bits; }
+    
+    /**
+     * Allowed categories, ascending and without duplicates
+     */
+    const std::vector<int>& list() const { return values; }
+    
+private:
+    bool containsOutside(int category) const;
+    
+    std::vector<int> values;
+    uint64_t bits[DOMAIN_SIZE / 64] = {};
+    bool in_domain = true;
+};
\ No newline at end of file
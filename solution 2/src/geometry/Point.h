@@ -16,14 +16,38 @@ struct Point {
         : x(x_), y(y_), id(id_), group_id(group_id_), category(category_) {}
     
     /**
-     * Compare points for sorting by (y, x)
+     * Compare points for sorting by (y, x); id breaks ties so the order is total
      */
     bool operator<(const Point& other) const {
         if (y != other.y) return y < other.y;
-        return x < other.x;
+        if (x != other.x) return x < other.x;
+        return id < other.id;
     }
     
     bool operator==(const Point& other) const {
         return x == other.x && y == other.y;
     }
+};
+
+/**
+ * Position in the (y, x, id) result order, used as a keyset pagination cursor:
+ * the next page starts strictly after this key
+ */
+struct KeysetCursor {
+    double y = 0.0;
+    double x = 0.0;
+    long long id = 0;
+    
+    KeysetCursor() = default;
+    KeysetCursor(double y_, double x_, long long id_) : y(y_), x(x_), id(id_) {}
+    explicit KeysetCursor(const Point& p) : y(p.y), x(p.x), id(p.id) {}
+    
+    /**
+     * Check if a point comes strictly after this cursor in (y, x, id) order
+     */
+    bool precedes(const Point& p) const {
+        if (p.y != y) return y < p.y;
+        if (p.x != x) return x < p.x;
+        return id < p.id;
+    }
 };
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "Rectangle.h"
+#include "ScanKernel.h"
 #include <sstream>
 #include <algorithm>
 
@@ -7,6 +8,10 @@ bool Rectangle::contains(const Point& point) const {
            point.y >= p_min.y && point.y <= p_max.y;
 }
 
+void Rectangle::containsBatch(const double* xs, const double* ys, size_t count, uint64_t* mask) const {
+    ScanKernel::rectangleMask(*this, xs, ys, count, mask);
+}
+
 bool Rectangle::intersects(const Rectangle& other) const {
     return !(p_max.x < other.p_min.x || p_min.x > other.p_max.x ||
              p_max.y < other.p_min.y || p_min.y > other.p_max.y);
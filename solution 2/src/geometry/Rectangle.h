@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Point.h"
+#include <cstdint>
 #include <string>
 
 /**
@@ -23,6 +24,15 @@ public:
      */
     bool contains(const Point& point) const;
     
+    /**
+     * Test many points at once (vectorized, see ScanKernel)
+     * @param xs x coordinates
+     * @param ys y coordinates
+     * @param count Number of points
+     * @param mask Output selection bitmask, (count + 63) / 64 words: bit i set if point i is inside
+     */
+    void containsBatch(const double* xs, const double* ys, size_t count, uint64_t* mask) const;
+    
     /**
      * Check if this rectangle intersects with another rectangle
      * @param other Other rectangle to test
@@ -0,0 +1,414 @@
+#include "ScanKernel.h"
+#include "Rectangle.h"
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCAN_KERNEL_X86 1
+#endif
+
+PointColumns::PointColumns(const std::vector<Point>& points) {
+    xs.reserve(points.size());
+    ys.reserve(points.size());
+    categories.reserve(points.size());
+    group_ids.reserve(points.size());
+    ids.reserve(points.size());
+    
+    for (const auto& point : points) {
+        xs.push_back(point.x);
+        ys.push_back(point.y);
+        categories.push_back(point.category);
+        group_ids.push_back(point.group_id);
+        ids.push_back(point.id);
+    }
+}
+
+namespace {
+
+// -1 = not detected yet, otherwise a SimdLevel value
+std::atomic<int> selected_level{-1};
+
+SimdLevel detectSimdLevel() {
+#ifdef SCAN_KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+void rectangleMaskScalar(double min_x, double min_y, double max_x, double max_y,
+                         const double* xs, const double* ys, size_t begin, size_t rows, uint64_t* mask) {
+    for (size_t i = begin; i < rows; ++i) {
+        bool inside = (xs[i] >= min_x) & (xs[i] <= max_x) & (ys[i] >= min_y) & (ys[i] <= max_y);
+        mask[i / 64] |= static_cast<uint64_t>(inside) << (i % 64);
+    }
+}
+
+void categoryMaskScalar(const int* categories, size_t begin, size_t rows, const std::vector<int>& allowed, uint64_t* mask) {
+    for (size_t i = begin; i < rows; ++i) {
+        bool match = false;
+        for (int category : allowed) {
+            match |= categories[i] == category;
+        }
+        if (!match) {
+            mask[i / 64] &= ~(uint64_t(1) << (i % 64));
+        }
+    }
+}
+
+void categoryBitsScalar(const int* categories, size_t begin, size_t rows, const CategoryMask& allowed, uint64_t* mask) {
+    for (size_t i = begin; i < rows; ++i) {
+        if (!allowed.contains(categories[i])) {
+            mask[i / 64] &= ~(uint64_t(1) << (i % 64));
+        }
+    }
+}
+
+template <typename Code>
+void codeRangeMaskScalar(const Code* codes, size_t begin, size_t rows, Code lo, Code hi, uint64_t* mask) {
+    for (size_t i = begin; i < rows; ++i) {
+        if (codes[i] < lo || codes[i] > hi) {
+            mask[i / 64] &= ~(uint64_t(1) << (i % 64));
+        }
+    }
+}
+
+#ifdef SCAN_KERNEL_X86
+
+__attribute__((target("avx2")))
+size_t rectangleMaskAvx2(double min_x, double min_y, double max_x, double max_y,
+                         const double* xs, const double* ys, size_t rows, uint64_t* mask) {
+    const __m256d lo_x = _mm256_set1_pd(min_x), hi_x = _mm256_set1_pd(max_x);
+    const __m256d lo_y = _mm256_set1_pd(min_y), hi_y = _mm256_set1_pd(max_y);
+    
+    // 16 groups of 4 rows fill one mask word
+    size_t full = rows / 64 * 64;
+    for (size_t base = 0; base < full; base += 64) {
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j += 4) {
+            __m256d x = _mm256_loadu_pd(xs + base + j);
+            __m256d y = _mm256_loadu_pd(ys + base + j);
+            __m256d in_x = _mm256_and_pd(_mm256_cmp_pd(x, lo_x, _CMP_GE_OQ), _mm256_cmp_pd(x, hi_x, _CMP_LE_OQ));
+            __m256d in_y = _mm256_and_pd(_mm256_cmp_pd(y, lo_y, _CMP_GE_OQ), _mm256_cmp_pd(y, hi_y, _CMP_LE_OQ));
+            word |= static_cast<uint64_t>(_mm256_movemask_pd(_mm256_and_pd(in_x, in_y))) << j;
+        }
+        mask[base / 64] = word;
+    }
+    return full;
+}
+
+__attribute__((target("avx2")))
+size_t categoryMaskAvx2(const int* categories, size_t rows, const std::vector<int>& allowed, uint64_t* mask) {
+    size_t full = rows / 64 * 64;
+    for (size_t base = 0; base < full; base += 64) {
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j += 8) {
+            __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(categories + base + j));
+            __m256i match = _mm256_setzero_si256();
+            for (int category : allowed) {
+                match = _mm256_or_si256(match, _mm256_cmpeq_epi32(values, _mm256_set1_epi32(category)));
+            }
+            word |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(match)))) << j;
+        }
+        mask[base / 64] &= word;
+    }
+    return full;
+}
+
+// Membership in a 256-bit category mask: 32-bit word category / 32 of the mask is fetched with one
+// cross-lane permute and shifted so bit category % 32 lands in bit 0. The permute only reads the
+// low 3 index bits, so categories outside 0..255 (negative ones too, compared unsigned) are masked off.
+__attribute__((target("avx2")))
+size_t categoryBitsAvx2(const int* categories, size_t rows, const uint64_t* bits, uint64_t* mask) {
+    const __m256i table = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bits));
+    const __m256i limit = _mm256_set1_epi32(CategoryMask::DOMAIN_SIZE - 1);
+    const __m256i low_bits = _mm256_set1_epi32(31);
+    const __m256i one = _mm256_set1_epi32(1);
+    
+    size_t full = rows / 64 * 64;
+    for (size_t base = 0; base < full; base += 64) {
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j += 8) {
+            __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(categories + base + j));
+            __m256i lookup = _mm256_permutevar8x32_epi32(table, _mm256_srli_epi32(values, 5));
+            __m256i bit = _mm256_and_si256(_mm256_srlv_epi32(lookup, _mm256_and_si256(values, low_bits)), one);
+            __m256i in_domain = _mm256_cmpeq_epi32(_mm256_min_epu32(values, limit), values);
+            __m256i match = _mm256_and_si256(_mm256_cmpeq_epi32(bit, one), in_domain);
+            word |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(match)))) << j;
+        }
+        mask[base / 64] &= word;
+    }
+    return full;
+}
+
+// Unsigned range test without unsigned compares: code - lo wraps around below lo,
+// so lo <= code <= hi exactly when min(code - lo, hi - lo) == code - lo
+__attribute__((target("avx2")))
+inline __m256i inRangeAvx2(__m256i codes, __m256i lo, __m256i span) {
+    __m256i shifted = _mm256_sub_epi32(codes, lo);
+    return _mm256_cmpeq_epi32(_mm256_min_epu32(shifted, span), shifted);
+}
+
+template <typename Code>
+__attribute__((target("avx2")))
+size_t codeRangeMaskAvx2(const Code* codes, size_t rows, uint32_t lo, uint32_t hi, uint64_t* mask) {
+    const __m256i low = _mm256_set1_epi32(static_cast<int>(lo));
+    const __m256i span = _mm256_set1_epi32(static_cast<int>(hi - lo));
+    
+    // 8 codes widened to 32 bits per step
+    size_t full = rows / 64 * 64;
+    for (size_t base = 0; base < full; base += 64) {
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j += 8) {
+            __m256i values;
+            if constexpr (sizeof(Code) == 2) {
+                values = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + base + j)));
+            } else {
+                values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(codes + base + j));
+            }
+            __m256i inside = inRangeAvx2(values, low, span);
+            word |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(inside)))) << j;
+        }
+        mask[base / 64] &= word;
+    }
+    return full;
+}
+
+__attribute__((target("avx512f")))
+size_t rectangleMaskAvx512(double min_x, double min_y, double max_x, double max_y,
+                           const double* xs, const double* ys, size_t rows, uint64_t* mask) {
+    const __m512d lo_x = _mm512_set1_pd(min_x), hi_x = _mm512_set1_pd(max_x);
+    const __m512d lo_y = _mm512_set1_pd(min_y), hi_y = _mm512_set1_pd(max_y);
+    
+    size_t full = rows / 64 * 64;
+    for (size_t base = 0; base < full; base += 64) {
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j += 8) {
+            __m512d x = _mm512_loadu_pd(xs + base + j);
+            __m512d y = _mm512_loadu_pd(ys + base + j);
+            __mmask8 inside = _mm512_cmp_pd_mask(x, lo_x, _CMP_GE_OQ) & _mm512_cmp_pd_mask(x, hi_x, _CMP_LE_OQ) &
+                              _mm512_cmp_pd_mask(y, lo_y, _CMP_GE_OQ) & _mm512_cmp_pd_mask(y, hi_y, _CMP_LE_OQ);
+            word |= static_cast<uint64_t>(inside) << j;
+        }
+        mask[base / 64] = word;
+    }
+    return full;
+}
+
+__attribute__((target("avx512f")))
+size_t categoryMaskAvx512(const int* categories, size_t rows, const std::vector<int>& allowed, uint64_t* mask) {
+    size_t full = rows / 64 * 64;
+    for (size_t base = 0; base < full; base += 64) {
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j += 16) {
+            __m512i values = _mm512_loadu_si512(categories + base + j);
+            __mmask16 match = 0;
+            for (int category : allowed) {
+                match |= _mm512_cmpeq_epi32_mask(values, _mm512_set1_epi32(category));
+            }
+            word |= static_cast<uint64_t>(match) << j;
+        }
+        mask[base / 64] &= word;
+    }
+    return full;
+}
+
+// Same lookup as categoryBitsAvx2, with the 256-bit mask repeated in both halves of the permute table.
+// Zero-masked forms throughout: the plain ones trip -Wmaybe-uninitialized inside the GCC header.
+__attribute__((target("avx512f")))
+size_t categoryBitsAvx512(const int* categories, size_t rows, const uint64_t* bits, uint64_t* mask) {
+    uint64_t doubled[8];
+    std::memcpy(doubled, bits, 4 * sizeof(uint64_t));
+    std::memcpy(doubled + 4, bits, 4 * sizeof(uint64_t));
+    const __m512i table = _mm512_loadu_si512(doubled);
+    const __m512i limit = _mm512_set1_epi32(CategoryMask::DOMAIN_SIZE - 1);
+    const __m512i low_bits = _mm512_set1_epi32(31);
+    const __m512i one = _mm512_set1_epi32(1);
+    const __mmask16 lanes = 0xFFFF;
+    
+    size_t full = rows / 64 * 64;
+    for (size_t base = 0; base < full; base += 64) {
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j += 16) {
+            __m512i values = _mm512_loadu_si512(categories + base + j);
+            __m512i lookup = _mm512_maskz_permutexvar_epi32(lanes, _mm512_maskz_srli_epi32(lanes, values, 5), table);
+            __m512i shifted = _mm512_maskz_srlv_epi32(lanes, lookup, _mm512_and_si512(values, low_bits));
+            __mmask16 match = _mm512_test_epi32_mask(shifted, one) & _mm512_cmp_epu32_mask(values, limit, _MM_CMPINT_LE);
+            word |= static_cast<uint64_t>(match) << j;
+        }
+        mask[base / 64] &= word;
+    }
+    return full;
+}
+
+template <typename Code>
+__attribute__((target("avx512f")))
+size_t codeRangeMaskAvx512(const Code* codes, size_t rows, uint32_t lo, uint32_t hi, uint64_t* mask) {
+    const __m512i low = _mm512_set1_epi32(static_cast<int>(lo));
+    const __m512i span = _mm512_set1_epi32(static_cast<int>(hi - lo));
+    
+    size_t full = rows / 64 * 64;
+    for (size_t base = 0; base < full; base += 64) {
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j += 16) {
+            __m512i values;
+            if constexpr (sizeof(Code) == 2) {
+                // Zero-masked form: the plain one trips -Wmaybe-uninitialized inside the GCC header
+                __m256i narrow = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(codes + base + j));
+                values = _mm512_maskz_cvtepu16_epi32(static_cast<__mmask16>(0xFFFF), narrow);
+            } else {
+                values = _mm512_loadu_si512(codes + base + j);
+            }
+            __mmask16 inside = _mm512_cmp_epu32_mask(_mm512_sub_epi32(values, low), span, _MM_CMPINT_LE);
+            word |= static_cast<uint64_t>(inside) << j;
+        }
+        mask[base / 64] &= word;
+    }
+    return full;
+}
+
+#endif
+
+}
+
+SimdLevel ScanKernel::simdLevel() {
+    int level = selected_level.load(std::memory_order_relaxed);
+    if (level < 0) {
+        level = static_cast<int>(detectSimdLevel());
+        selected_level.store(level, std::memory_order_relaxed);
+    }
+    return static_cast<SimdLevel>(level);
+}
+
+const char* ScanKernel::simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX512: return "avx512";
+        case SimdLevel::AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+void ScanKernel::setSimdLevel(SimdLevel level) {
+    SimdLevel supported = detectSimdLevel();
+    selected_level.store(static_cast<int>(level <= supported ? level : supported), std::memory_order_relaxed);
+}
+
+void ScanKernel::rectangleMask(const Rectangle& region, const double* xs, const double* ys, size_t rows, uint64_t* mask) {
+    std::memset(mask, 0, maskWords(rows) * sizeof(uint64_t));
+    
+    double min_x = region.p_min.x, min_y = region.p_min.y;
+    double max_x = region.p_max.x, max_y = region.p_max.y;
+    size_t done = 0;
+    
+#ifdef SCAN_KERNEL_X86
+    switch (simdLevel()) {
+        case SimdLevel::AVX512:
+            done = rectangleMaskAvx512(min_x, min_y, max_x, max_y, xs, ys, rows, mask);
+            break;
+        case SimdLevel::AVX2:
+            done = rectangleMaskAvx2(min_x, min_y, max_x, max_y, xs, ys, rows, mask);
+            break;
+        default:
+            break;
+    }
+#endif
+    
+    // Scalar tail (or everything without SIMD)
+    rectangleMaskScalar(min_x, min_y, max_x, max_y, xs, ys, done, rows, mask);
+}
+
+void ScanKernel::andCategoryMask(const int* categories, size_t rows, const CategoryMask& allowed, uint64_t* mask) {
+    if (allowed.empty()) {
+        return;
+    }
+    
+    size_t done = 0;
+    
+    if (allowed.inDomain()) {
+#ifdef SCAN_KERNEL_X86
+        switch (simdLevel()) {
+            case SimdLevel::AVX512:
+                done = categoryBitsAvx512(categories, rows, allowed.words(), mask);
+                break;
+            case SimdLevel::AVX2:
+                done = categoryBitsAvx2(categories, rows, allowed.words(), mask);
+                break;
+            default:
+                break;
+        }
+#endif
+        categoryBitsScalar(categories, done, rows, allowed, mask);
+        return;
+    }
+    
+    // Categories outside the mask domain: compare against the list
+#ifdef SCAN_KERNEL_X86
+    switch (simdLevel()) {
+        case SimdLevel::AVX512:
+            done = categoryMaskAvx512(categories, rows, allowed.list(), mask);
+            break;
+        case SimdLevel::AVX2:
+            done = categoryMaskAvx2(categories, rows, allowed.list(), mask);
+            break;
+        default:
+            break;
+    }
+#endif
+    
+    categoryMaskScalar(categories, done, rows, allowed.list(), mask);
+}
+
+void ScanKernel::selectAll(size_t rows, uint64_t* mask) {
+    std::memset(mask, 0xFF, rows / 64 * sizeof(uint64_t));
+    if (rows % 64 != 0) {
+        mask[rows / 64] = (uint64_t(1) << (rows % 64)) - 1;
+    }
+}
+
+namespace {
+
+template <typename Code>
+void andCodeRange(const Code* codes, size_t rows, Code lo, Code hi, uint64_t* mask) {
+    if (lo > hi) {
+        std::memset(mask, 0, ScanKernel::maskWords(rows) * sizeof(uint64_t));
+        return;
+    }
+    
+    size_t done = 0;
+    
+#ifdef SCAN_KERNEL_X86
+    switch (ScanKernel::simdLevel()) {
+        case SimdLevel::AVX512:
+            done = codeRangeMaskAvx512(codes, rows, lo, hi, mask);
+            break;
+        case SimdLevel::AVX2:
+            done = codeRangeMaskAvx2(codes, rows, lo, hi, mask);
+            break;
+        default:
+            break;
+    }
+#endif
+    
+    codeRangeMaskScalar(codes, done, rows, lo, hi, mask);
+}
+
+} // namespace
+
+void ScanKernel::andCodeRangeMask(const uint16_t* codes, size_t rows, uint16_t lo, uint16_t hi, uint64_t* mask) {
+    andCodeRange(codes, rows, lo, hi, mask);
+}
+
+void ScanKernel::andCodeRangeMask(const uint32_t* codes, size_t rows, uint32_t lo, uint32_t hi, uint64_t* mask) {
+    andCodeRange(codes, rows, lo, hi, mask);
+}
+
+void ScanKernel::andCodeRangeMask(const uint64_t* codes, size_t rows, uint64_t lo, uint64_t hi, uint64_t* mask) {
+    // No 64-bit lanes worth widening to; the scalar loop vectorizes on its own
+    if (lo > hi) {
+        std::memset(mask, 0, maskWords(rows) * sizeof(uint64_t));
+        return;
+    }
+    codeRangeMaskScalar(codes, 0, rows, lo, hi, mask);
+}
\ No newline at end of file
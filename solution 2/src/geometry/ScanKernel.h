@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CategoryMask.h"
+#include "Point.h"
+
+class Rectangle;
+
+/**
+ * Instruction set used by the scan kernels
+ */
+enum class SimdLevel {
+    Scalar,
+    AVX2,
+    AVX512
+};
+
+/**
+ * Points split into one array per attribute, for column-at-a-time scans
+ */
+struct PointColumns {
+    std::vector<double> xs;
+    std::vector<double> ys;
+    std::vector<int> categories;
+    std::vector<long long> group_ids;
+    std::vector<long long> ids;
+    
+    PointColumns() = default;
+    explicit PointColumns(const std::vector<Point>& points);
+    
+    size_t size() const { return xs.size(); }
+    Point row(size_t i) const { return Point(xs[i], ys[i], ids[i], group_ids[i], categories[i]); }
+};
+
+/**
+ * Vectorized predicates over coordinate and category columns
+ *
+ * Each kernel fills a selection bitmask: bit i of word i / 64 is set when row i
+ * passes. Bits past the row count are always zero, so masks can be combined
+ * word by word and iterated with count-trailing-zeros. The widest instruction
+ * set the CPU supports (AVX-512, AVX2, or plain scalar code) is picked once at
+ * runtime; all paths give identical results, including for NaN coordinates.
+ */
+class ScanKernel {
+public:
+    /**
+     * Number of 64-bit mask words needed for a row count
+     */
+    static size_t maskWords(size_t rows) { return (rows + 63) / 64; }
+    
+    /**
+     * Instruction set selected for this CPU
+     */
+    static SimdLevel simdLevel();
+    
+    /**
+     * Name of an instruction set level ("scalar", "avx2", "avx512")
+     */
+    static const char* simdLevelName(SimdLevel level);
+    
+    /**
+     * Force an instruction set (for tests and benchmarks); levels the CPU lacks fall back to the best supported one
+     */
+    static void setSimdLevel(SimdLevel level);
+    
+    /**
+     * Mark rows whose (x, y) lies inside a rectangle (inclusive bounds)
+     * @param region Rectangle to test
+     * @param xs x column
+     * @param ys y column
+     * @param rows Number of rows
+     * @param mask Output, maskWords(rows) words (overwritten)
+     */
+    static void rectangleMask(const Rectangle& region, const double* xs, const double* ys, size_t rows, uint64_t* mask);
+    
+    /**
+     * Clear the bits of rows whose category is not in the allowed set
+     * Sets within CategoryMask::DOMAIN_SIZE cost one mask lookup per row whatever their size;
+     * others compare against each listed category.
+     * @param categories Category column
+     * @param rows Number of rows
+     * @param allowed Allowed categories (empty = keep all)
+     * @param mask Mask to narrow, maskWords(rows) words
+     */
+    static void andCategoryMask(const int* categories, size_t rows, const CategoryMask& allowed, uint64_t* mask);
+    
+    /**
+     * Select every row
+     * @param rows Number of rows
+     * @param mask Output, maskWords(rows) words (overwritten)
+     */
+    static void selectAll(size_t rows, uint64_t* mask);
+    
+    /**
+     * Clear the bits of rows whose code lies outside [lo, hi] (unsigned, inclusive)
+     * Used on frame-of-reference packed columns, where codes are offsets from a block base.
+     * @param codes Code column
+     * @param rows Number of rows
+     * @param lo Smallest code to keep
+     * @param hi Largest code to keep
+     * @param mask Mask to narrow, maskWords(rows) words
+     */
+    static void andCodeRangeMask(const uint16_t* codes, size_t rows, uint16_t lo, uint16_t hi, uint64_t* mask);
+    static void andCodeRangeMask(const uint32_t* codes, size_t rows, uint32_t lo, uint32_t hi, uint64_t* mask);
+    static void andCodeRangeMask(const uint64_t* codes, size_t rows, uint64_t lo, uint64_t hi, uint64_t* mask);
+    
+    /**
+     * Call visit(row) for every set bit, in ascending row order
+     */
+    template <typename Visitor>
+    static void forEachSelected(const uint64_t* mask, size_t rows, Visitor visit) {
+        for (size_t w = 0; w < maskWords(rows); ++w) {
+            uint64_t bits = mask[w];
+            while (bits != 0) {
+                visit(w * 64 + static_cast<size_t>(__builtin_ctzll(bits)));
+                bits &= bits - 1;
+            }
+        }
+    }
+};
\ No newline at end of file
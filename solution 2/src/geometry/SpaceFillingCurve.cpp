@@ -0,0 +1,162 @@
+#include "SpaceFillingCurve.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+CurveType parseCurveType(const std::string& name) {
+    if (name == "morton") return CurveType::Morton;
+    if (name == "hilbert") return CurveType::Hilbert;
+    throw std::runtime_error("Unknown curve type: " + name + " (expected morton or hilbert)");
+}
+
+std::string curveTypeName(CurveType type) {
+    return type == CurveType::Morton ? "morton" : "hilbert";
+}
+
+SpaceFillingCurve::SpaceFillingCurve(CurveType type, const Rectangle& bounds, int order)
+    : type(type), bounds(bounds), order(order) {
+    if (order < 1 || order > 31) {
+        throw std::runtime_error("Curve order must be between 1 and 31, got " + std::to_string(order));
+    }
+    if (!bounds.isValid()) {
+        throw std::runtime_error("Invalid curve bounds: " + bounds.toString());
+    }
+    cells_per_axis = 1u << order;
+}
+
+uint64_t SpaceFillingCurve::encode(const Point& point) const {
+    return encodeCell(cellX(point.x), cellY(point.y));
+}
+
+uint64_t SpaceFillingCurve::encodeCell(uint32_t cell_x, uint32_t cell_y) const {
+    return type == CurveType::Morton ? mortonKey(cell_x, cell_y)
+                                     : hilbertKey(cell_x, cell_y, cells_per_axis);
+}
+
+std::vector<KeyRange> SpaceFillingCurve::decompose(const Rectangle& region, size_t max_ranges) const {
+    std::vector<KeyRange> ranges;
+    if (!region.isValid() || !region.intersects(bounds)) {
+        return ranges;
+    }
+    
+    // Cell span touched by the region
+    uint32_t x0 = cellX(region.p_min.x), x1 = cellX(region.p_max.x);
+    uint32_t y0 = cellY(region.p_min.y), y1 = cellY(region.p_max.y);
+    
+    // Quadtree block: origin cell and log2 of its side
+    struct Block {
+        uint32_t x;
+        uint32_t y;
+        int level;
+    };
+    
+    auto blockRange = [this](const Block& block) {
+        uint64_t cells = 1ull << (2 * block.level);
+        uint64_t first = encodeCell(block.x, block.y) & ~(cells - 1);
+        return KeyRange{first, first + cells - 1};
+    };
+    
+    // Refine partially covered blocks level by level while the range budget allows
+    std::vector<Block> partial = {{0, 0, order}};
+    max_ranges = std::max<size_t>(max_ranges, 1);
+    
+    while (!partial.empty()) {
+        if (ranges.size() + partial.size() * 4 > max_ranges) {
+            for (const auto& block : partial) {
+                ranges.push_back(blockRange(block));
+            }
+            break;
+        }
+        
+        std::vector<Block> next;
+        for (const auto& block : partial) {
+            int child_level = block.level - 1;
+            uint32_t side = 1u << child_level;
+            
+            for (uint32_t dy = 0; dy < 2; ++dy) {
+                for (uint32_t dx = 0; dx < 2; ++dx) {
+                    Block child{block.x + dx * side, block.y + dy * side, child_level};
+                    uint32_t cx1 = child.x + side - 1;
+                    uint32_t cy1 = child.y + side - 1;
+                    
+                    if (cx1 < x0 || child.x > x1 || cy1 < y0 || child.y > y1) {
+                        continue;  // Disjoint
+                    }
+                    if (child_level == 0 || (child.x >= x0 && cx1 <= x1 && child.y >= y0 && cy1 <= y1)) {
+                        ranges.push_back(blockRange(child));  // Fully covered
+                    } else {
+                        next.push_back(child);
+                    }
+                }
+            }
+        }
+        partial = std::move(next);
+    }
+    
+    // Sort and merge adjacent ranges
+    std::sort(ranges.begin(), ranges.end(), [](const KeyRange& a, const KeyRange& b) {
+        return a.first < b.first;
+    });
+    
+    std::vector<KeyRange> merged;
+    for (const auto& range : ranges) {
+        if (!merged.empty() && range.first <= merged.back().last + 1) {
+            merged.back().last = std::max(merged.back().last, range.last);
+        } else {
+            merged.push_back(range);
+        }
+    }
+    
+    return merged;
+}
+
+uint32_t SpaceFillingCurve::cellX(double x) const {
+    double width = bounds.p_max.x - bounds.p_min.x;
+    if (width <= 0.0) return 0;
+    double cell = std::floor((x - bounds.p_min.x) / width * cells_per_axis);
+    return static_cast<uint32_t>(std::clamp(cell, 0.0, static_cast<double>(cells_per_axis - 1)));
+}
+
+uint32_t SpaceFillingCurve::cellY(double y) const {
+    double height = bounds.p_max.y - bounds.p_min.y;
+    if (height <= 0.0) return 0;
+    double cell = std::floor((y - bounds.p_min.y) / height * cells_per_axis);
+    return static_cast<uint32_t>(std::clamp(cell, 0.0, static_cast<double>(cells_per_axis - 1)));
+}
+
+uint64_t SpaceFillingCurve::mortonKey(uint32_t cell_x, uint32_t cell_y) {
+    // Spread the bits of a 32-bit value so they occupy the even positions
+    auto spread = [](uint64_t v) {
+        v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+        v = (v | (v << 8)) & 0x00FF00FF00FF00FFull;
+        v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0Full;
+        v = (v | (v << 2)) & 0x3333333333333333ull;
+        v = (v | (v << 1)) & 0x5555555555555555ull;
+        return v;
+    };
+    return spread(cell_x) | (spread(cell_y) << 1);
+}
+
+uint64_t SpaceFillingCurve::hilbertKey(uint32_t cell_x, uint32_t cell_y, uint32_t side) {
+    uint64_t key = 0;
+    uint32_t x = cell_x;
+    uint32_t y = cell_y;
+    
+    for (uint32_t s = side / 2; s > 0; s /= 2) {
+        uint32_t rx = (x & s) > 0 ? 1 : 0;
+        uint32_t ry = (y & s) > 0 ? 1 : 0;
+        key += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+        
+        // Rotate the quadrant so the sub-curve has the canonical orientation
+        if (ry == 0) {
+            if (rx == 1) {
+                x = side - 1 - x;
+                y = side - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    
+    return key;
+}
\ No newline at end of file
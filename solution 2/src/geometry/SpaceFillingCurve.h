@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Rectangle.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Curve used to linearize 2D grid cells into a single sortable key
+ */
+enum class CurveType {
+    Morton,   // Z-order: bit interleaving, cheap but with long jumps between quadrants
+    Hilbert   // Hilbert curve: consecutive keys are always adjacent cells
+};
+
+/**
+ * Parse a curve name ("morton" or "hilbert")
+ * @throws std::runtime_error for unknown names
+ */
+CurveType parseCurveType(const std::string& name);
+
+/**
+ * Get the name of a curve type
+ */
+std::string curveTypeName(CurveType type);
+
+/**
+ * Inclusive range of curve keys
+ */
+struct KeyRange {
+    uint64_t first;
+    uint64_t last;
+};
+
+/**
+ * Space-filling curve over a fixed 2^order x 2^order grid laid on a bounding box
+ *
+ * Points are snapped to their grid cell and keyed by the cell's position along
+ * the curve. Every aligned quadtree block of cells covers one contiguous key
+ * range, so a rectangle decomposes into a short list of key ranges that a
+ * btree or BRIN index on the key can scan.
+ */
+class SpaceFillingCurve {
+public:
+    /**
+     * @param type Curve to use
+     * @param bounds Area covered by the grid; points outside are clamped to the border cells
+     * @param order Bits per axis (1..31); keys use 2 * order bits
+     */
+    SpaceFillingCurve(CurveType type, const Rectangle& bounds, int order = 16);
+    
+    /**
+     * Key of the grid cell containing a point
+     */
+    uint64_t encode(const Point& point) const;
+    
+    /**
+     * Key of a grid cell given by its column and row
+     */
+    uint64_t encodeCell(uint32_t cell_x, uint32_t cell_y) const;
+    
+    /**
+     * Cover a rectangle with key ranges
+     * @param region Query rectangle
+     * @param max_ranges Upper bound on the number of ranges; coarser blocks are
+     *        emitted once refining further would exceed it (ranges may then
+     *        contain cells outside the region, so callers still filter exactly)
+     * @return Sorted, non-overlapping ranges covering every cell the region touches
+     */
+    std::vector<KeyRange> decompose(const Rectangle& region, size_t max_ranges = 64) const;
+    
+    CurveType getType() const { return type; }
+    int getOrder() const { return order; }
+    const Rectangle& getBounds() const { return bounds; }
+
+private:
+    CurveType type;
+    Rectangle bounds;
+    int order;
+    uint32_t cells_per_axis;
+    
+    uint32_t cellX(double x) const;
+    uint32_t cellY(double y) const;
+    
+    static uint64_t mortonKey(uint32_t cell_x, uint32_t cell_y);
+    static uint64_t hilbertKey(uint32_t cell_x, uint32_t cell_y, uint32_t side);
+};
\ No newline at end of file
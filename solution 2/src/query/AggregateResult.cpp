@@ -0,0 +1,77 @@
+#include "AggregateResult.h"
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+OutputMode parseOutputMode(const std::string& name) {
+    if (name == "points") return OutputMode::Points;
+    if (name == "count") return OutputMode::Count;
+    if (name == "per_category") return OutputMode::PerCategory;
+    if (name == "per_group") return OutputMode::PerGroup;
+    if (name == "bbox") return OutputMode::BoundingBox;
+    
+    throw std::runtime_error("Unknown output mode: " + name +
+                             " (expected points, count, per_category, per_group or bbox)");
+}
+
+std::string outputModeName(OutputMode mode) {
+    switch (mode) {
+        case OutputMode::Points: return "points";
+        case OutputMode::Count: return "count";
+        case OutputMode::PerCategory: return "per_category";
+        case OutputMode::PerGroup: return "per_group";
+        case OutputMode::BoundingBox: return "bbox";
+    }
+    return "unknown";
+}
+
+AggregateResult aggregatePoints(const std::vector<Point>& points, OutputMode mode) {
+    AggregateResult result(mode);
+    result.count = points.size();
+    
+    if (mode == OutputMode::PerCategory || mode == OutputMode::PerGroup) {
+        std::map<long long, size_t> counts;
+        for (const Point& p : points) {
+            ++counts[mode == OutputMode::PerCategory ? p.category : p.group_id];
+        }
+        result.buckets.assign(counts.begin(), counts.end());
+    }
+    
+    if (mode == OutputMode::BoundingBox && !points.empty()) {
+        double min_x = points[0].x, max_x = points[0].x;
+        double min_y = points[0].y, max_y = points[0].y;
+        for (const Point& p : points) {
+            min_x = std::min(min_x, p.x);
+            max_x = std::max(max_x, p.x);
+            min_y = std::min(min_y, p.y);
+            max_y = std::max(max_y, p.y);
+        }
+        result.bounding_box = Rectangle(min_x, min_y, max_x, max_y);
+    }
+    
+    return result;
+}
+
+void mergeAggregateResults(AggregateResult& into, const AggregateResult& other) {
+    into.count += other.count;
+    
+    if (!other.buckets.empty()) {
+        std::map<long long, size_t> counts(into.buckets.begin(), into.buckets.end());
+        for (const auto& [key, count] : other.buckets) {
+            counts[key] += count;
+        }
+        into.buckets.assign(counts.begin(), counts.end());
+    }
+    
+    if (other.bounding_box) {
+        if (!into.bounding_box) {
+            into.bounding_box = other.bounding_box;
+        } else {
+            Rectangle& box = *into.bounding_box;
+            box.p_min.x = std::min(box.p_min.x, other.bounding_box->p_min.x);
+            box.p_min.y = std::min(box.p_min.y, other.bounding_box->p_min.y);
+            box.p_max.x = std::max(box.p_max.x, other.bounding_box->p_max.x);
+            box.p_max.y = std::max(box.p_max.y, other.bounding_box->p_max.y);
+        }
+    }
+}
\ No newline at end of file
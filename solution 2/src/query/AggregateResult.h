@@ -0,0 +1,57 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../geometry/Point.h"
+#include "../geometry/Rectangle.h"
+
+/**
+ * What a query returns: the matching points, or an aggregate over them
+ */
+enum class OutputMode {
+    Points,        // Full (y, x)-sorted point list (default)
+    Count,         // Number of matching points
+    PerCategory,   // Number of matching points per category
+    PerGroup,      // Number of matching points per group
+    BoundingBox    // Bounding box of the matching points
+};
+
+/**
+ * Parse the "output" field of a query
+ * @param name One of "points", "count", "per_category", "per_group", "bbox"
+ * @throws std::runtime_error on unknown names
+ */
+OutputMode parseOutputMode(const std::string& name);
+
+/**
+ * Name of an output mode as written in query JSON
+ */
+std::string outputModeName(OutputMode mode);
+
+/**
+ * Aggregate answer of a crop query (everything except OutputMode::Points)
+ */
+struct AggregateResult {
+    OutputMode mode = OutputMode::Count;
+    size_t count = 0;                                   // Total number of matching points
+    std::vector<std::pair<long long, size_t>> buckets;  // (category or group_id, count), ascending by key
+    std::optional<Rectangle> bounding_box;              // BoundingBox mode, only when count > 0
+    
+    AggregateResult() = default;
+    explicit AggregateResult(OutputMode m) : mode(m) {}
+};
+
+/**
+ * Compute an aggregate client-side from already filtered points
+ * (used by the brute force path and by backends without SQL aggregates)
+ */
+AggregateResult aggregatePoints(const std::vector<Point>& points, OutputMode mode);
+
+/**
+ * Combine aggregates computed over disjoint point sets (e.g. one per shard)
+ * @param into Aggregate to extend; must have the same mode as other
+ * @param other Aggregate to add
+ */
+void mergeAggregateResults(AggregateResult& into, const AggregateResult& other);
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include "CategoryIndex.h"
+#include <algorithm>
+#include <cstring>
+
+CategoryIndex::CategoryIndex(const std::vector<int>& categories) {
+    std::map<int, std::vector<uint32_t>> rows;
+    for (size_t row = 0; row < categories.size(); ++row) {
+        rows[categories[row]].push_back(static_cast<uint32_t>(row));
+    }
+    for (const auto& [category, category_rows] : rows) {
+        bitmaps.emplace(category, RoaringBitmap(category_rows));
+    }
+}
+
+std::vector<const RoaringBitmap*> CategoryIndex::find(const std::vector<int>& categories) const {
+    std::vector<int> distinct = categories;
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    
+    std::vector<const RoaringBitmap*> found;
+    for (int category : distinct) {
+        auto it = bitmaps.find(category);
+        if (it != bitmaps.end()) {
+            found.push_back(&it->second);
+        }
+    }
+    return found;
+}
+
+size_t CategoryIndex::cardinality(const std::vector<int>& categories) const {
+    size_t total = 0;
+    for (const RoaringBitmap* bitmap : find(categories)) {
+        total += bitmap->cardinality();
+    }
+    return total;
+}
+
+void CategoryIndex::selectMask(const std::vector<int>& categories, size_t first, size_t count, uint64_t* mask) const {
+    // Union of the category bitmaps over the range
+    std::memset(mask, 0, (count + 63) / 64 * sizeof(uint64_t));
+    for (const RoaringBitmap* bitmap : find(categories)) {
+        bitmap->orMask(first, count, mask);
+    }
+}
+
+size_t CategoryIndex::memoryUsage() const {
+    size_t bytes = 0;
+    for (const auto& [category, bitmap] : bitmaps) {
+        bytes += sizeof(category) + bitmap.memoryUsage();
+    }
+    return bytes;
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "RoaringBitmap.h"
+
+/**
+ * Bitmap index of a category column: one RoaringBitmap of row ordinals per category
+ *
+ * Categories are a small domain, so a category filter is a union of a few
+ * bitmaps. selectMask() evaluates it straight into selection words for a run
+ * of rows, ready to AND with a rectangle mask; cardinality() tells the caller
+ * whether the filter is selective enough to test the rectangle only on the
+ * selected rows instead.
+ */
+class CategoryIndex {
+public:
+    CategoryIndex() = default;
+    
+    /**
+     * Index a category column
+     * @param categories Category of every row, by ordinal
+     */
+    explicit CategoryIndex(const std::vector<int>& categories);
+    
+    /**
+     * Number of rows in any of the given categories
+     */
+    size_t cardinality(const std::vector<int>& categories) const;
+    
+    /**
+     * Select the rows of [first, first + count) that are in any of the given categories
+     * @param categories Categories to select (non-empty)
+     * @param first First row of the range
+     * @param count Number of rows
+     * @param mask Output, ScanKernel::maskWords(count) words (overwritten); bit i stands for row first + i
+     */
+    void selectMask(const std::vector<int>& categories, size_t first, size_t count, uint64_t* mask) const;
+    
+    /**
+     * Heap memory held, in bytes
+     */
+    size_t memoryUsage() const;
+    
+private:
+    std::map<int, RoaringBitmap> bitmaps;
+    
+    /**
+     * Bitmaps of the distinct listed categories that have rows
+     */
+    std::vector<const RoaringBitmap*> find(const std::vector<int>& categories) const;
+};
\ No newline at end of file
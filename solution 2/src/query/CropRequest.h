@@ -0,0 +1,22 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+#include "../geometry/Point.h"
+#include "../geometry/Rectangle.h"
+
+/**
+ * Parameters of one crop query (same meaning as the DatabaseManager::executeCropQuery arguments)
+ */
+struct CropRequest {
+    Rectangle crop_region;
+    Rectangle valid_region;
+    std::vector<int> category_filter;
+    std::vector<long long> group_filter;
+    std::optional<bool> proper_constraint;
+    std::optional<size_t> limit;
+    std::optional<KeysetCursor> after;
+    
+    CropRequest() = default;
+    CropRequest(const Rectangle& crop, const Rectangle& valid) : crop_region(crop), valid_region(valid) {}
+};
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "GroupIndex.h"
+#include "PointRows.h"
+#include <algorithm>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <string>
+
+GroupIndex::GroupIndex(const std::vector<Point>& table) {
+    if (table.size() > PointRows::MAX_TABLE_SIZE) {
+        throw std::runtime_error("GroupIndex failed: table of " + std::to_string(table.size())
+                                 + " points exceeds 32-bit ordinals");
+    }
+    
+    // Group by id, each group in result order
+    rows.resize(table.size());
+    std::iota(rows.begin(), rows.end(), uint32_t(0));
+    std::sort(rows.begin(), rows.end(), [&table](uint32_t a, uint32_t b) {
+        if (table[a].group_id != table[b].group_id) return table[a].group_id < table[b].group_id;
+        return table[a] < table[b];
+    });
+    
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const Point& point = table[rows[i]];
+        if (group_ids.empty() || group_ids.back() != point.group_id) {
+            group_ids.push_back(point.group_id);
+            offsets.push_back(i);
+            bounds.emplace_back(point.x, point.y, point.x, point.y);
+            continue;
+        }
+        Rectangle& box = bounds.back();
+        box.p_min.x = std::min(box.p_min.x, point.x);
+        box.p_min.y = std::min(box.p_min.y, point.y);
+        box.p_max.x = std::max(box.p_max.x, point.x);
+        box.p_max.y = std::max(box.p_max.y, point.y);
+    }
+    offsets.push_back(rows.size());
+}
+
+std::vector<size_t> GroupIndex::lookup(const std::unordered_set<long long>& ids) const {
+    std::vector<size_t> groups;
+    groups.reserve(ids.size());
+    for (long long id : ids) {
+        auto it = std::lower_bound(group_ids.begin(), group_ids.end(), id);
+        if (it != group_ids.end() && *it == id) {
+            groups.push_back(static_cast<size_t>(it - group_ids.begin()));
+        }
+    }
+    return groups;
+}
+
+size_t GroupIndex::pointCount(const std::vector<size_t>& groups) const {
+    size_t total = 0;
+    for (size_t g : groups) {
+        total += offsets[g + 1] - offsets[g];
+    }
+    return total;
+}
+
+std::vector<uint32_t> GroupIndex::cropGroups(const std::vector<Point>& table, const std::vector<size_t>& groups,
+                                             const Rectangle& crop, const CategoryMask& categories,
+                                             const std::optional<KeysetCursor>& after, std::optional<size_t> limit) const {
+    // The part of each slice in the crop's y band and after the cursor
+    struct Slice {
+        const uint32_t* next;
+        const uint32_t* end;
+    };
+    std::vector<Slice> slices;
+    for (size_t g : groups) {
+        if (!crop.intersects(bounds[g])) {
+            continue;
+        }
+        const uint32_t* first = rows.data() + offsets[g];
+        const uint32_t* last = rows.data() + offsets[g + 1];
+        first = std::partition_point(first, last, [&](uint32_t row) { return table[row].y < crop.p_min.y; });
+        if (after.has_value()) {
+            first = std::partition_point(first, last, [&](uint32_t row) { return !after->precedes(table[row]); });
+        }
+        last = std::partition_point(first, last, [&](uint32_t row) { return table[row].y <= crop.p_max.y; });
+        if (first < last) {
+            slices.push_back({first, last});
+        }
+    }
+    
+    auto accepts = [&](const Point& point) {
+        if (point.x < crop.p_min.x || point.x > crop.p_max.x) return false;
+        return categories.empty() || categories.contains(point.category);
+    };
+    
+    // k-way merge: heap of slices ordered by their next point, smallest first
+    auto greater = [&](size_t a, size_t b) { return table[*slices[b].next] < table[*slices[a].next]; };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+    for (size_t s = 0; s < slices.size(); ++s) {
+        heap.push(s);
+    }
+    
+    std::vector<uint32_t> result;
+    while (!heap.empty() && (!limit.has_value() || result.size() < limit.value())) {
+        size_t s = heap.top();
+        heap.pop();
+        uint32_t row = *slices[s].next++;
+        if (accepts(table[row])) {
+            result.push_back(row);
+        }
+        if (slices[s].next != slices[s].end) {
+            heap.push(s);
+        }
+    }
+    return result;
+}
+
+size_t GroupIndex::memoryUsage() const {
+    return group_ids.capacity() * sizeof(long long) + offsets.capacity() * sizeof(size_t) +
+           rows.capacity() * sizeof(uint32_t) + bounds.capacity() * sizeof(Rectangle);
+}
\ No newline at end of file
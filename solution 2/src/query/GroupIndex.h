@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <unordered_set>
+#include <vector>
+#include "../geometry/CategoryMask.h"
+#include "../geometry/Point.h"
+#include "../geometry/Rectangle.h"
+
+/**
+ * Inverted index from group to its points, in compressed sparse row form
+ *
+ * Groups get dense ordinals in id order. The points of group g are the
+ * ordinals rows[offsets[g]] .. rows[offsets[g + 1]) into the indexed table,
+ * in (y, x, id) order, and bounds[g] is their bounding box. A crop restricted
+ * to a few groups then reads only those slices: groups whose box misses the
+ * crop are skipped, each remaining slice is binary-searched to the crop's y
+ * band (and the cursor), and the slices are merged into result order.
+ */
+class GroupIndex {
+public:
+    GroupIndex() = default;
+    
+    /**
+     * Index a table of points
+     * @param table Points to index; ordinals refer to positions in it
+     * @throws std::runtime_error if the table is too large for 32-bit ordinals (see PointRows)
+     */
+    explicit GroupIndex(const std::vector<Point>& table);
+    
+    size_t groupCount() const { return group_ids.size(); }
+    
+    long long groupId(size_t group) const { return group_ids[group]; }
+    
+    /**
+     * Ordinals of the given group ids; ids without points are dropped
+     */
+    std::vector<size_t> lookup(const std::unordered_set<long long>& ids) const;
+    
+    /**
+     * Total number of points in the given groups
+     */
+    size_t pointCount(const std::vector<size_t>& groups) const;
+    
+    /**
+     * Points of the given groups inside crop, after the cursor, in (y, x, id) order
+     * @param table The indexed table
+     * @param groups Group ordinals (from lookup)
+     * @param crop Crop rectangle
+     * @param categories Allowed categories (empty = any)
+     * @param after Return only points strictly after this cursor
+     * @param limit Stop after this many points
+     * @return Ordinals into table
+     */
+    std::vector<uint32_t> cropGroups(const std::vector<Point>& table, const std::vector<size_t>& groups,
+                                     const Rectangle& crop, const CategoryMask& categories,
+                                     const std::optional<KeysetCursor>& after, std::optional<size_t> limit) const;
+    
+    /**
+     * Heap memory held, in bytes
+     */
+    size_t memoryUsage() const;
+    
+private:
+    std::vector<long long> group_ids;   // Ordinal -> group id, ascending
+    std::vector<size_t> offsets;        // groupCount() + 1 slice boundaries into rows
+    std::vector<uint32_t> rows;         // Ordinals into the table, grouped, each slice in (y, x, id) order
+    std::vector<Rectangle> bounds;      // Bounding box of each group's points
+};
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "JsonParser.h"
+#include "../geometry/CategoryMask.h"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -33,7 +35,14 @@ QuerySpec JsonParser::parseQueryString(const std::string& json_content) {
         
         CropQuery crop_query = parseCropQuery(query_obj["operator_crop"]);
         
-        return QuerySpec(valid_region, crop_query);
+        QuerySpec query_spec(valid_region, crop_query);
+        
+        // Parse optional output mode (defaults to the full point list)
+        if (root.contains("output")) {
+            query_spec.output_mode = parseOutputMode(root["output"].get<std::string>());
+        }
+        
+        return query_spec;
         
     } catch (const nlohmann::json::exception& e) {
         throw std::runtime_error("JSON parsing error: " + std::string(e.what()));
@@ -74,12 +83,53 @@ CropQuery JsonParser::parseCropQuery(const nlohmann::json& json_crop) {
     // Parse required region
     crop_query.region = parseRectangle(json_crop["region"]);
     
-    // Parse optional category filter
+    // Parse optional category filter: one of category, category_in or category_range.
+    // Combining them is rejected, since a reader could take it to narrow the match as well as widen it.
+    int category_fields = static_cast<int>(json_crop.contains("category")) +
+                          static_cast<int>(json_crop.contains("category_in")) +
+                          static_cast<int>(json_crop.contains("category_range"));
+    if (category_fields > 1) {
+        throw std::runtime_error("category, category_in and category_range cannot be combined");
+    }
+    
     if (json_crop.contains("category")) {
         int category = json_crop["category"].get<int>();
         crop_query.category_filter.push_back(category);
     }
     
+    if (json_crop.contains("category_in")) {
+        const auto& categories_array = json_crop["category_in"];
+        if (!categories_array.is_array() || categories_array.empty()) {
+            throw std::runtime_error("category_in must be a non-empty array");
+        }
+        
+        for (const auto& category : categories_array) {
+            crop_query.category_filter.push_back(category.get<int>());
+        }
+    }
+    
+    if (json_crop.contains("category_range")) {
+        const auto& range = json_crop["category_range"];
+        validateRequiredFields(range, {"min", "max"});
+        int min_category = range["min"].get<int>();
+        int max_category = range["max"].get<int>();
+        if (min_category > max_category) {
+            throw std::runtime_error("category_range min must be <= max");
+        }
+        if (static_cast<long long>(max_category) - min_category >= CategoryMask::DOMAIN_SIZE) {
+            throw std::runtime_error("category_range may span at most " + std::to_string(CategoryMask::DOMAIN_SIZE) +
+                                     " categories");
+        }
+        
+        for (long long category = min_category; category <= max_category; ++category) {
+            crop_query.category_filter.push_back(static_cast<int>(category));
+        }
+    }
+    
+    std::sort(crop_query.category_filter.begin(), crop_query.category_filter.end());
+    crop_query.category_filter.erase(std::unique(crop_query.category_filter.begin(), crop_query.category_filter.end()),
+                                     crop_query.category_filter.end());
+    
     // Parse optional one_of_groups filter
     if (json_crop.contains("one_of_groups")) {
         const auto& groups_array = json_crop["one_of_groups"];
@@ -97,6 +147,23 @@ CropQuery JsonParser::parseCropQuery(const nlohmann::json& json_crop) {
         crop_query.proper = json_crop["proper"].get<bool>();
     }
     
+    // Parse optional page size
+    if (json_crop.contains("limit")) {
+        long long limit = json_crop["limit"].get<long long>();
+        if (limit <= 0) {
+            throw std::runtime_error("limit must be a positive integer");
+        }
+        crop_query.limit = static_cast<size_t>(limit);
+    }
+    
+    // Parse optional keyset cursor (last point of the previous page)
+    if (json_crop.contains("after")) {
+        const auto& after = json_crop["after"];
+        validateRequiredFields(after, {"y", "x", "id"});
+        crop_query.after = KeysetCursor(after["y"].get<double>(), after["x"].get<double>(),
+                                        after["id"].get<long long>());
+    }
+    
     return crop_query;
 }
 
@@ -5,15 +5,18 @@
 #include <optional>
 #include <nlohmann/json.hpp>
 #include "../geometry/Rectangle.h"
+#include "AggregateResult.h"
 
 /**
  * Represents a crop query operation with all its parameters
  */
 struct CropQuery {
     Rectangle region;                    // Required crop region
-    std::vector<int> category_filter;    // Optional category filter
+    std::vector<int> category_filter;    // Optional allowed categories, ascending (category, category_in or category_range)
     std::vector<long long> group_filter; // Optional one_of_groups filter
     std::optional<bool> proper;          // Optional proper flag: true=proper, false=improper, nullopt=ignore
+    std::optional<size_t> limit;         // Optional page size: first N points in (y, x, id) order
+    std::optional<KeysetCursor> after;   // Optional cursor: only points strictly after this (y, x, id)
     
     CropQuery() = default;
     CropQuery(const Rectangle& r) : region(r) {}
@@ -25,6 +28,7 @@ struct CropQuery {
 struct QuerySpec {
     Rectangle valid_region;
     CropQuery crop_query;
+    OutputMode output_mode = OutputMode::Points;  // Optional "output": rows or an aggregate
     
     QuerySpec() = default;
     QuerySpec(const Rectangle& valid_r, const CropQuery& crop_q)
@@ -0,0 +1,28 @@
+#include "PointRows.h"
+#include <stdexcept>
+#include <string>
+
+PointRows::PointRows(std::vector<Point> points)
+    : table(std::make_shared<const std::vector<Point>>(std::move(points))) {
+}
+
+PointRows::PointRows(Table table, std::vector<uint32_t> rows)
+    : table(std::move(table)), rows(std::move(rows)), whole_table(false) {
+    if (this->table && this->table->size() > MAX_TABLE_SIZE) {
+        throw std::runtime_error("PointRows failed: table of " + std::to_string(this->table->size())
+                                 + " points exceeds 32-bit ordinals");
+    }
+}
+
+std::vector<Point> PointRows::materialize() const {
+    if (coversTable()) {
+        return *table;
+    }
+    
+    std::vector<Point> points;
+    points.reserve(size());
+    for (uint32_t row : rows) {
+        points.push_back((*table)[row]);
+    }
+    return points;
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+#include "../geometry/Point.h"
+
+/**
+ * Compact result rows: 32-bit ordinals into a shared, immutable table of points
+ *
+ * A result that selects from a table it does not own (the brute force cache,
+ * an operand of a set operation) carries 4 bytes per row instead of a 40-byte
+ * Point, and copying the result copies only the ordinals. Coordinates and
+ * attributes are read from the table where they are needed: writing the
+ * output file, aggregating, or materialize(). Rows built from a vector of
+ * points own that vector as their table and store no ordinals at all.
+ */
+class PointRows {
+public:
+    using Table = std::shared_ptr<const std::vector<Point>>;
+    
+    static constexpr size_t MAX_TABLE_SIZE = size_t(std::numeric_limits<uint32_t>::max()) + 1;
+    
+    /**
+     * No rows
+     */
+    PointRows() = default;
+    
+    /**
+     * Take ownership of points; every point is a row, in the given order
+     */
+    explicit PointRows(std::vector<Point> points);
+    
+    /**
+     * Select rows of a shared table
+     * @param table Base table (at most MAX_TABLE_SIZE points)
+     * @param rows Ordinals into the table, in result order
+     * @throws std::runtime_error if the table is too large for 32-bit ordinals
+     */
+    PointRows(Table table, std::vector<uint32_t> rows);
+    
+    size_t size() const { return whole_table ? (table ? table->size() : 0) : rows.size(); }
+    bool empty() const { return size() == 0; }
+    
+    /**
+     * Position in the table of the i-th row
+     */
+    uint32_t ordinal(size_t i) const { return whole_table ? static_cast<uint32_t>(i) : rows[i]; }
+    
+    /**
+     * The i-th row, read in place from the table
+     */
+    const Point& operator[](size_t i) const { return (*table)[ordinal(i)]; }
+    
+    const Point& back() const { return (*this)[size() - 1]; }
+    
+    /**
+     * Base table the ordinals refer to (null when there are no rows)
+     */
+    const Table& getTable() const { return table; }
+    
+    /**
+     * Check whether the rows are the whole table in table order, so the table can be used as is
+     */
+    bool coversTable() const { return whole_table && table; }
+    
+    /**
+     * Check whether both sets of rows index the same table, so their ordinals can be compared directly
+     */
+    bool sharesTable(const PointRows& other) const { return table && table == other.table; }
+    
+    /**
+     * Gather the rows into a vector of points
+     */
+    std::vector<Point> materialize() const;
+    
+private:
+    Table table;
+    std::vector<uint32_t> rows;     // Unused when whole_table is set
+    bool whole_table = true;
+};
\ No newline at end of file
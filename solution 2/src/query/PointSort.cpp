@@ -0,0 +1,191 @@
+#include "PointSort.h"
+#include "../backend/MorselScheduler.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+const size_t MIN_CHUNK_KEYS = 1 << 16;      // Smallest share of keys worth a thread
+const int DIGIT_BITS = 11;                  // 2048-entry histograms stay in L1/L2
+const size_t RADIX = size_t(1) << DIGIT_BITS;
+const int WORD_PASSES = (64 + DIGIT_BITS - 1) / DIGIT_BITS;
+const int PASSES = 2 * WORD_PASSES;         // x digits low to high, then y digits
+
+/**
+ * What the radix passes move around: the (y, x) key and where the point came from
+ */
+struct SortKey {
+    uint64_t y;
+    uint64_t x;
+    uint32_t index;
+};
+
+using Histogram = std::array<size_t, RADIX>;
+
+inline uint32_t digit(const SortKey& key, int pass) {
+    uint64_t word = pass < WORD_PASSES ? key.x : key.y;
+    return static_cast<uint32_t>(word >> ((pass % WORD_PASSES) * DIGIT_BITS)) & (RADIX - 1);
+}
+
+size_t chunkCount(size_t n, const MorselScheduler& scheduler) {
+    return std::max<size_t>(1, std::min(scheduler.getThreadCount(), n / MIN_CHUNK_KEYS));
+}
+
+bool useRadix(size_t n, const MorselScheduler& scheduler) {
+    // On one thread the passes cost more than comparing the points directly, so the
+    // radix sort only runs when at least two threads get MIN_CHUNK_KEYS keys each
+    return n <= std::numeric_limits<uint32_t>::max() && chunkCount(n, scheduler) > 1;
+}
+
+/**
+ * Radix sort the (y, x) keys of n points, then order equal keys by id
+ * @param n Number of points
+ * @param point_at Returns the i-th point (a const reference that stays valid during the sort)
+ * @return The keys in result order; each index is the position i of its point
+ */
+template <typename PointAt>
+std::vector<SortKey> sortKeys(size_t n, const PointAt& point_at, MorselScheduler& scheduler) {
+    size_t chunks = chunkCount(n, scheduler);
+    auto chunk_first = [&](size_t c) { return n * c / chunks; };
+    
+    // Build the keys and the per-chunk digit counts of every pass in one read of the points
+    std::vector<SortKey> keys(n);
+    std::vector<std::array<Histogram, PASSES>> chunk_counts(chunks);
+    scheduler.parallelFor(chunks, [&](size_t c) {
+        auto& counts = chunk_counts[c];
+        for (auto& histogram : counts) {
+            histogram.fill(0);
+        }
+        for (size_t i = chunk_first(c); i < chunk_first(c + 1); ++i) {
+            const Point& point = point_at(i);
+            keys[i] = {orderedKey(point.y), orderedKey(point.x), static_cast<uint32_t>(i)};
+            for (int pass = 0; pass < PASSES; ++pass) {
+                ++counts[pass][digit(keys[i], pass)];
+            }
+        }
+    });
+    
+    std::array<Histogram, PASSES> totals{};
+    for (const auto& counts : chunk_counts) {
+        for (int pass = 0; pass < PASSES; ++pass) {
+            for (size_t d = 0; d < RADIX; ++d) {
+                totals[pass][d] += counts[pass][d];
+            }
+        }
+    }
+    
+    std::vector<SortKey> buffer(n);
+    std::vector<Histogram> offsets(chunks);
+    bool first_pass = true;
+    
+    for (int pass = 0; pass < PASSES; ++pass) {
+        // A digit that is the same in every key does not reorder anything
+        if (std::find(totals[pass].begin(), totals[pass].end(), n) != totals[pass].end()) {
+            continue;
+        }
+        
+        // Chunks hold different keys after a scatter, so only the first pass can reuse the initial counts
+        if (!first_pass) {
+            scheduler.parallelFor(chunks, [&](size_t c) {
+                Histogram& histogram = chunk_counts[c][pass];
+                histogram.fill(0);
+                for (size_t i = chunk_first(c); i < chunk_first(c + 1); ++i) {
+                    ++histogram[digit(keys[i], pass)];
+                }
+            });
+        }
+        first_pass = false;
+        
+        // Stable scatter: digit-major, then chunk order
+        size_t position = 0;
+        for (size_t d = 0; d < RADIX; ++d) {
+            for (size_t c = 0; c < chunks; ++c) {
+                offsets[c][d] = position;
+                position += chunk_counts[c][pass][d];
+            }
+        }
+        
+        scheduler.parallelFor(chunks, [&](size_t c) {
+            Histogram& next = offsets[c];
+            for (size_t i = chunk_first(c); i < chunk_first(c + 1); ++i) {
+                buffer[next[digit(keys[i], pass)]++] = keys[i];
+            }
+        });
+        keys.swap(buffer);
+    }
+    buffer.clear();
+    buffer.shrink_to_fit();
+    
+    // Equal (y, x) keys are still in input order; the result order breaks such ties by id
+    auto by_id = [&](const SortKey& a, const SortKey& b) {
+        return point_at(a.index).id < point_at(b.index).id;
+    };
+    for (size_t first = 0; first < n;) {
+        size_t last = first + 1;
+        while (last < n && keys[last].y == keys[first].y && keys[last].x == keys[first].x) {
+            ++last;
+        }
+        if (last - first > 1 && !std::is_sorted(keys.begin() + first, keys.begin() + last, by_id)) {
+            std::sort(keys.begin() + first, keys.begin() + last, by_id);
+        }
+        first = last;
+    }
+    
+    return keys;
+}
+
+} // namespace
+
+uint64_t orderedKey(double value) {
+    const uint64_t SIGN = uint64_t(1) << 63;
+    if (value == 0.0) {
+        value = 0.0;
+    }
+    
+    // Positive doubles order like their bit patterns; negative ones in reverse
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & SIGN) ? ~bits : bits | SIGN;
+}
+
+void sortPoints(std::vector<Point>& points) {
+    size_t n = points.size();
+    MorselScheduler& scheduler = MorselScheduler::shared();
+    if (!useRadix(n, scheduler)) {
+        std::sort(points.begin(), points.end());
+        return;
+    }
+    
+    std::vector<SortKey> keys = sortKeys(n, [&](size_t i) -> const Point& { return points[i]; }, scheduler);
+    
+    size_t chunks = chunkCount(n, scheduler);
+    std::vector<Point> sorted(n);
+    scheduler.parallelFor(chunks, [&](size_t c) {
+        for (size_t i = n * c / chunks; i < n * (c + 1) / chunks; ++i) {
+            sorted[i] = points[keys[i].index];
+        }
+    });
+    points.swap(sorted);
+}
+
+void sortRows(const std::vector<Point>& table, std::vector<uint32_t>& rows) {
+    size_t n = rows.size();
+    MorselScheduler& scheduler = MorselScheduler::shared();
+    if (!useRadix(n, scheduler)) {
+        std::sort(rows.begin(), rows.end(), [&table](uint32_t a, uint32_t b) { return table[a] < table[b]; });
+        return;
+    }
+    
+    std::vector<SortKey> keys = sortKeys(n, [&](size_t i) -> const Point& { return table[rows[i]]; }, scheduler);
+    
+    size_t chunks = chunkCount(n, scheduler);
+    std::vector<uint32_t> sorted(n);
+    scheduler.parallelFor(chunks, [&](size_t c) {
+        for (size_t i = n * c / chunks; i < n * (c + 1) / chunks; ++i) {
+            sorted[i] = rows[keys[i].index];
+        }
+    });
+    rows.swap(sorted);
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "../geometry/Point.h"
+
+/**
+ * Sort points into result order, (y, x, id)
+ *
+ * Inputs too small to give two threads 64K keys each use std::sort. Larger
+ * ones get a parallel LSD radix sort over compact 128-bit order-preserving
+ * (y, x) keys that carry the point's position; only the keys move during the
+ * passes, and the 40-byte points are gathered once at the end. Points with equal (y, x) are then ordered by id.
+ * Same result as std::sort with Point::operator< for any non-NaN coordinates.
+ * @param points Points to sort in place
+ */
+void sortPoints(std::vector<Point>& points);
+
+/**
+ * Sort ordinals into a table by the result order of the points they refer to
+ *
+ * Same algorithm as sortPoints, but nothing is gathered: only the ordinals are permuted.
+ * @param table Points the ordinals index
+ * @param rows Ordinals to sort in place
+ */
+void sortRows(const std::vector<Point>& table, std::vector<uint32_t>& rows);
+
+/**
+ * Map a double to an unsigned integer with the same order (-0.0 and 0.0 map to the same key)
+ */
+uint64_t orderedKey(double value);
\ No newline at end of file
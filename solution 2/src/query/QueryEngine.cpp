@@ -1,17 +1,55 @@
 #include "QueryEngine.h"
+#include "PointSort.h"
+#include "../backend/CropFilter.h"
+#include "../backend/DatabaseBackend.h"
+#include "../backend/InMemoryBackend.h"
+#include "../backend/MorselScheduler.h"
+#include "../backend/ShardedBackend.h"
 #include <iostream>
 #include <chrono>
 #include <set>
-#include <map>
 #include <algorithm>
+#include <iterator>
+#include <unordered_set>
 
-QueryEngine::QueryEngine(const std::string& connection_string, bool test_mode) : test_mode(test_mode) {
-    db_manager = std::make_unique<DatabaseManager>(connection_string);
+namespace {
+
+// Crops restricted to groups holding at most 1/GROUP_SCAN_FRACTION of all points read those groups' slices
+// of the group index instead of scanning every point
+constexpr size_t GROUP_SCAN_FRACTION = 16;
+
+// Category filters selecting at most 1/SPARSE_CATEGORY_FRACTION of all points test the rectangle only on
+// the rows their bitmaps select; denser ones AND the bitmaps with the vectorized rectangle mask
+constexpr size_t SPARSE_CATEGORY_FRACTION = 16;
+
+}
+
+QueryEngine::QueryEngine(const std::string& connection_string, bool test_mode, size_t pool_size) : test_mode(test_mode) {
+    db_manager = std::make_unique<DatabaseManager>(connection_string, pool_size);
+    backend = std::make_unique<DatabaseBackend>(*db_manager);
     
     if (test_mode) {
         std::cout << "Loading all points into memory for brute force testing..." << std::endl;
-        cached_points = db_manager->getAllPoints();
+        cached_points = std::make_shared<const std::vector<Point>>(db_manager->getAllPoints());
+        cached_columns = PointColumns(*cached_points);
+        cached_groups = GroupIndex(*cached_points);
+        cached_categories = CategoryIndex(cached_columns.categories);
+    }
+}
+
+QueryEngine::QueryEngine(const std::vector<std::string>& shard_connection_strings, bool test_mode, size_t pool_size) : test_mode(test_mode) {
+    auto sharded = std::make_unique<ShardedBackend>(shard_connection_strings, pool_size);
+    std::cout << "Sharded mode: " << sharded->getShardCount() << " shards" << std::endl;
+    
+    if (test_mode) {
+        std::cout << "Loading all points of all shards into memory for brute force testing..." << std::endl;
+        cached_points = std::make_shared<const std::vector<Point>>(sharded->getAllPoints());
+        cached_columns = PointColumns(*cached_points);
+        cached_groups = GroupIndex(*cached_points);
+        cached_categories = CategoryIndex(cached_columns.categories);
     }
+    
+    backend = std::move(sharded);
 }
 
 QueryEngine::~QueryEngine() = default;
@@ -33,6 +71,15 @@ QueryResult QueryEngine::executeQuery(const QuerySpec& query_spec) {
     std::cout << "Valid region: " << query_spec.valid_region.toString() << std::endl;
     std::cout << "Crop region: " << query_spec.crop_query.region.toString() << std::endl;
     
+    if (query_spec.crop_query.limit.has_value()) {
+        std::cout << "Page size: " << query_spec.crop_query.limit.value() << std::endl;
+    }
+    
+    if (query_spec.crop_query.after.has_value()) {
+        const KeysetCursor& after = query_spec.crop_query.after.value();
+        std::cout << "After: (y=" << after.y << ", x=" << after.x << ", id=" << after.id << ")" << std::endl;
+    }
+    
     if (!query_spec.crop_query.category_filter.empty()) {
         std::cout << "Category filter: ";
         for (size_t i = 0; i < query_spec.crop_query.category_filter.size(); ++i) {
@@ -55,31 +102,132 @@ QueryResult QueryEngine::executeQuery(const QuerySpec& query_spec) {
         std::cout << "Proper constraint: " << (query_spec.crop_query.proper.value() ? "true (proper groups only)" : "false (improper groups only)") << std::endl;
     }
     
+    if (query_spec.output_mode != OutputMode::Points) {
+        std::cout << "Output mode: " << outputModeName(query_spec.output_mode) << std::endl;
+    }
+    
     // Record start time for query execution
     auto query_start = std::chrono::high_resolution_clock::now();
     
+    CropRequest request = toCropRequest(query_spec);
+    
+    // Aggregate modes are computed by the database; no rows are transferred
+    if (query_spec.output_mode != OutputMode::Points) {
+        AggregateResult aggregate = backend->executeAggregate(request, query_spec.output_mode);
+        
+        auto query_end = std::chrono::high_resolution_clock::now();
+        auto query_duration = std::chrono::duration_cast<std::chrono::milliseconds>(query_end - query_start);
+        
+        std::cout << "Aggregate query executed successfully in " << query_duration.count() << " ms." << std::endl;
+        
+        QueryResult result(aggregate);
+        result.setQueryDuration(query_duration.count());
+        return result;
+    }
+    
     // Execute the database query
-    std::vector<Point> result_points = db_manager->executeCropQuery(
+    std::vector<Point> result_points = backend->executeCrop(request);
+    
+    // Calculate query execution time
+    auto query_end = std::chrono::high_resolution_clock::now();
+    auto query_duration = std::chrono::duration_cast<std::chrono::milliseconds>(query_end - query_start);
+    
+    std::cout << "Query executed successfully in " << query_duration.count() << " ms." << std::endl;
+    
+    QueryResult result(std::move(result_points));
+    result.setQueryDuration(query_duration.count());
+    setNextCursor(result, query_spec.crop_query);
+    return result;
+}
+
+std::string QueryEngine::explainQuery(const QuerySpec& query_spec) {
+    validateQuery(query_spec);
+    
+    return requireDatabase("explain").explainCropQuery(
         query_spec.crop_query.region,
         query_spec.valid_region,
         query_spec.crop_query.category_filter,
         query_spec.crop_query.group_filter,
-        query_spec.crop_query.proper
+        query_spec.crop_query.proper,
+        query_spec.crop_query.limit,
+        query_spec.crop_query.after
     );
+}
+
+std::vector<QueryResult> QueryEngine::executeQueryBatch(const std::vector<QuerySpec>& query_specs) {
+    DatabaseManager& database = requireDatabase("batch execution");
+    
+    std::vector<CropRequest> requests;
+    requests.reserve(query_specs.size());
+    
+    for (const auto& query_spec : query_specs) {
+        validateQuery(query_spec);
+        requests.push_back(toCropRequest(query_spec));
+    }
+    
+    std::cout << "\n=== Executing Batch of " << requests.size() << " Crop Queries ===" << std::endl;
+    
+    auto query_start = std::chrono::high_resolution_clock::now();
+    
+    std::vector<std::vector<Point>> batch_points = database.executeCropQueryBatch(requests);
     
-    // Calculate query execution time
     auto query_end = std::chrono::high_resolution_clock::now();
     auto query_duration = std::chrono::duration_cast<std::chrono::milliseconds>(query_end - query_start);
     
-    std::cout << "Query executed successfully in " << query_duration.count() << " ms." << std::endl;
+    std::cout << "Batch executed successfully in " << query_duration.count() << " ms." << std::endl;
     
-    QueryResult result(result_points);
-    result.setQueryDuration(query_duration.count());
-    return result;
+    std::vector<QueryResult> results;
+    results.reserve(batch_points.size());
+    for (size_t i = 0; i < batch_points.size(); ++i) {
+        // Batches always fetch rows; aggregate modes are reduced client-side
+        OutputMode mode = query_specs[i].output_mode;
+        QueryResult result = mode == OutputMode::Points
+            ? QueryResult(std::move(batch_points[i]))
+            : QueryResult(aggregatePoints(batch_points[i], mode));
+        result.setQueryDuration(query_duration.count());
+        setNextCursor(result, query_specs[i].crop_query);
+        results.push_back(std::move(result));
+    }
+    
+    return results;
+}
+
+void QueryEngine::setMortonKeyRanges(size_t max_ranges) {
+    DatabaseManager& database = requireDatabase("Morton key ranges");
+    database.setMortonKeyRanges(max_ranges);
+    if (max_ranges > 0 && !database.hasMortonKeys()) {
+        std::cout << "Warning: no Morton keys in the database, --morton_ranges has no effect" << std::endl;
+    }
+}
+
+void QueryEngine::setParallelBands(size_t max_bands, size_t min_rows) {
+    requireDatabase("parallel bands").setParallelBands(max_bands, min_rows);
+}
+
+void QueryEngine::selectBackend(const std::string& name) {
+    DatabaseManager& database = requireDatabase("backend selection");
+    
+    if (name == "database") {
+        backend = std::make_unique<DatabaseBackend>(database);
+        return;
+    }
+    
+    auto build_start = std::chrono::high_resolution_clock::now();
+    
+    std::unique_ptr<InMemoryBackend> in_memory = test_mode
+        ? createInMemoryBackend(name, *cached_points)
+        : createInMemoryBackend(name, database.getAllPoints());
+    
+    auto build_end = std::chrono::high_resolution_clock::now();
+    auto build_duration = std::chrono::duration_cast<std::chrono::milliseconds>(build_end - build_start);
+    std::cout << "Backend " << name << " ready (" << in_memory->size() << " points) in "
+              << build_duration.count() << " ms" << std::endl;
+    
+    backend = std::move(in_memory);
 }
 
 bool QueryEngine::testConnection() {
-    return db_manager && db_manager->testConnection();
+    return backend && backend->testConnection();
 }
 
 QueryResult QueryEngine::executeQueryBruteForce(const QuerySpec& query_spec) {
@@ -93,127 +241,196 @@ QueryResult QueryEngine::executeQueryBruteForce(const QuerySpec& query_spec) {
     
     auto query_start = std::chrono::high_resolution_clock::now();
     
-    std::vector<Point> result_points;
-    
     // Step 1: Find proper groups if proper constraint is specified
     std::set<long long> proper_groups;
     if (query_spec.crop_query.proper.has_value()) {
-        // Only analyze groups when proper constraint is specified
-        std::map<long long, std::vector<Point>> groups_map;
+        // Only analyze groups when proper constraint is specified: a group is proper
+        // unless one of its points falls outside the valid region
+        size_t rows = cached_columns.size();
+        std::vector<uint64_t> within_valid(ScanKernel::maskWords(rows));
+        query_spec.valid_region.containsBatch(cached_columns.xs.data(), cached_columns.ys.data(), rows, within_valid.data());
         
-        // Group points by group_id
-        for (const auto& point : cached_points) {
-            groups_map[point.group_id].push_back(point);
-        }
-        
-        // Check which groups are entirely within valid region
-        for (const auto& [group_id, group_points] : groups_map) {
-            bool all_within_valid = true;
-            for (const auto& point : group_points) {
-                if (!query_spec.valid_region.contains(Point(point.x, point.y))) {
-                    all_within_valid = false;
-                    break;
-                }
-            }
-            if (all_within_valid) {
-                proper_groups.insert(group_id);
+        std::set<long long> all_groups(cached_columns.group_ids.begin(), cached_columns.group_ids.end());
+        std::set<long long> improper_groups;
+        for (size_t row = 0; row < rows; ++row) {
+            if ((within_valid[row / 64] >> (row % 64) & 1) == 0) {
+                improper_groups.insert(cached_columns.group_ids[row]);
             }
         }
+        std::set_difference(all_groups.begin(), all_groups.end(), improper_groups.begin(), improper_groups.end(),
+                            std::inserter(proper_groups, proper_groups.end()));
         
         if (query_spec.crop_query.proper.value()) {
             std::cout << "Found " << proper_groups.size() << " proper groups within valid region" << std::endl;
         } else {
-            std::cout << "Found " << (groups_map.size() - proper_groups.size()) << " improper groups within valid region" << std::endl;
+            std::cout << "Found " << improper_groups.size() << " improper groups within valid region" << std::endl;
         }
     }
     // When proper is nullopt, proper_groups remains empty and valid_region is ignored for group logic
     
-    // Step 2: Filter points
-    for (const auto& point : cached_points) {
-        // Check if point is within crop region
-        if (!query_spec.crop_query.region.contains(Point(point.x, point.y))) {
-            continue;
-        }
-        
-        // Check category filter
-        if (!query_spec.crop_query.category_filter.empty()) {
-            bool category_match = false;
-            for (int cat : query_spec.crop_query.category_filter) {
-                if (point.category == cat) {
-                    category_match = true;
-                    break;
+    // Group filter and proper constraint as one group predicate, specialized once per morsel
+    CropFilter filter;
+    if (!query_spec.crop_query.group_filter.empty()) {
+        filter.restrict_groups = true;
+        filter.groups.insert(query_spec.crop_query.group_filter.begin(), query_spec.crop_query.group_filter.end());
+    }
+    if (query_spec.crop_query.proper.has_value()) {
+        // proper: true keeps only proper groups, proper: false only improper ones
+        if (query_spec.crop_query.proper.value()) {
+            std::unordered_set<long long> allowed;
+            for (long long group_id : proper_groups) {
+                if (!filter.restrict_groups || filter.groups.count(group_id) > 0) {
+                    allowed.insert(group_id);
                 }
             }
-            if (!category_match) continue;
+            filter.groups = std::move(allowed);
+            filter.restrict_groups = true;
+        } else {
+            filter.excluded.insert(proper_groups.begin(), proper_groups.end());
         }
+    }
+    
+    // Step 2: Few listed groups are read from the group index, already in order and windowed
+    size_t rows = cached_columns.size();
+    if (filter.restrict_groups) {
+        std::vector<size_t> groups = cached_groups.lookup(filter.groups);
+        groups.erase(std::remove_if(groups.begin(), groups.end(), [&](size_t g) {
+            return filter.excluded.count(cached_groups.groupId(g)) > 0;
+        }), groups.end());
         
-        // Check group filter
-        if (!query_spec.crop_query.group_filter.empty()) {
-            bool group_match = false;
-            for (long long grp : query_spec.crop_query.group_filter) {
-                if (point.group_id == grp) {
-                    group_match = true;
-                    break;
-                }
-            }
-            if (!group_match) continue;
+        if (cached_groups.pointCount(groups) * GROUP_SCAN_FRACTION <= rows) {
+            std::cout << "Reading " << groups.size() << " groups from the group index" << std::endl;
+            std::vector<uint32_t> result_rows = cached_groups.cropGroups(
+                *cached_points, groups, query_spec.crop_query.region, query_spec.crop_query.category_filter,
+                query_spec.crop_query.after, query_spec.crop_query.limit);
+            return bruteForceResult(PointRows(cached_points, std::move(result_rows)), query_spec, query_start);
         }
+    }
+    
+    // Otherwise filter points morsel by morsel - rectangle and category bitmaps over whole columns, the rest per selected row
+    const Rectangle& region = query_spec.crop_query.region;
+    const std::vector<int>& categories = query_spec.crop_query.category_filter;
+    bool sparse_categories = !categories.empty() &&
+        cached_categories.cardinality(categories) * SPARSE_CATEGORY_FRACTION <= rows;
+    size_t morsel_count = (rows + MorselScheduler::MORSEL_SIZE - 1) / MorselScheduler::MORSEL_SIZE;
+    std::vector<std::vector<uint32_t>> buffers(morsel_count);
+    
+    auto scan_morsel = [&](size_t m) {
+        size_t first = m * MorselScheduler::MORSEL_SIZE;
+        size_t count = std::min(MorselScheduler::MORSEL_SIZE, rows - first);
         
-        // Check proper constraint
-        if (query_spec.crop_query.proper.has_value()) {
-            bool is_proper_group = (proper_groups.find(point.group_id) != proper_groups.end());
-            
-            if (query_spec.crop_query.proper.value()) {
-                // proper: true - only proper groups
-                if (!is_proper_group) {
-                    continue;
-                }
-            } else {
-                // proper: false - only improper groups
-                if (is_proper_group) {
-                    continue;
+        std::vector<uint64_t> selection(ScanKernel::maskWords(count));
+        if (categories.empty()) {
+            region.containsBatch(cached_columns.xs.data() + first, cached_columns.ys.data() + first,
+                                 count, selection.data());
+        } else {
+            cached_categories.selectMask(categories, first, count, selection.data());
+            if (!sparse_categories) {
+                std::vector<uint64_t> inside(selection.size());
+                region.containsBatch(cached_columns.xs.data() + first, cached_columns.ys.data() + first,
+                                     count, inside.data());
+                for (size_t w = 0; w < selection.size(); ++w) {
+                    selection[w] &= inside[w];
                 }
             }
         }
         
-        result_points.push_back(point);
+        filter.dispatch<false>([&](const auto& accepts) {
+            ScanKernel::forEachSelected(selection.data(), count, [&](size_t row) {
+                Point point = cached_columns.row(first + row);
+                if ((!sparse_categories || region.contains(point)) && accepts(point)) {
+                    buffers[m].push_back(static_cast<uint32_t>(first + row));
+                }
+            });
+        });
+    };
+    
+    if (rows >= MorselScheduler::PARALLEL_THRESHOLD) {
+        MorselScheduler::shared().parallelFor(morsel_count, scan_morsel);
+    } else {
+        for (size_t m = 0; m < morsel_count; ++m) {
+            scan_morsel(m);
+        }
     }
     
-    // Step 3: Sort results by (y, x)
-    std::sort(result_points.begin(), result_points.end());
+    // Results are ordinals into the cached points; only the ordinals are sorted and windowed
+    std::vector<uint32_t> result_rows;
+    for (const auto& buffer : buffers) {
+        result_rows.insert(result_rows.end(), buffer.begin(), buffer.end());
+    }
+    
+    // Step 3: Sort results by (y, x, id)
+    sortRows(*cached_points, result_rows);
     
+    // Step 4: Apply keyset cursor and page size
+    applyKeysetWindow(*cached_points, result_rows, query_spec.crop_query);
+    return bruteForceResult(PointRows(cached_points, std::move(result_rows)), query_spec, query_start);
+}
+
+QueryResult QueryEngine::bruteForceResult(PointRows result_points, const QuerySpec& query_spec,
+                                          std::chrono::high_resolution_clock::time_point query_start) {
     auto query_end = std::chrono::high_resolution_clock::now();
     auto query_duration = std::chrono::duration_cast<std::chrono::milliseconds>(query_end - query_start);
     
     std::cout << "Brute force query executed in " << query_duration.count() << " ms." << std::endl;
     std::cout << "Found " << result_points.size() << " matching points" << std::endl;
     
-    QueryResult result(result_points);
+    if (query_spec.output_mode != OutputMode::Points) {
+        QueryResult result(aggregatePoints(result_points.materialize(), query_spec.output_mode));
+        result.setQueryDuration(query_duration.count());
+        return result;
+    }
+    
+    QueryResult result(std::move(result_points));
     result.setQueryDuration(query_duration.count());
+    setNextCursor(result, query_spec.crop_query);
     return result;
 }
 
+void QueryEngine::applyKeysetWindow(const std::vector<Point>& table, std::vector<uint32_t>& sorted_rows,
+                                    const CropQuery& crop_query) {
+    if (crop_query.after.has_value()) {
+        const KeysetCursor& after = crop_query.after.value();
+        auto first = std::partition_point(sorted_rows.begin(), sorted_rows.end(),
+                                          [&](uint32_t row) { return !after.precedes(table[row]); });
+        sorted_rows.erase(sorted_rows.begin(), first);
+    }
+    
+    if (crop_query.limit.has_value() && sorted_rows.size() > crop_query.limit.value()) {
+        sorted_rows.resize(crop_query.limit.value());
+    }
+}
+
+void QueryEngine::setNextCursor(QueryResult& result, const CropQuery& crop_query) {
+    // A full page means there may be more: continue after its last point
+    const PointRows& rows = result.getRows();
+    if (!result.isAggregate() && crop_query.limit.has_value() && !rows.empty()
+        && rows.size() == crop_query.limit.value()) {
+        result.setNextCursor(KeysetCursor(rows.back()));
+    }
+}
+
 DataBounds QueryEngine::getDataBounds() const {
     if (!test_mode) {
         throw std::runtime_error("getDataBounds() is only available in test mode");
     }
     
-    if (cached_points.empty()) {
+    if (cached_points->empty()) {
         throw std::runtime_error("No data loaded - cannot determine bounds");
     }
     
     DataBounds bounds;
-    bounds.total_points = cached_points.size();
+    bounds.total_points = cached_points->size();
     
     // Initialize with first point
-    const auto& first_point = cached_points[0];
+    const auto& first_point = cached_points->front();
     bounds.min_x = bounds.max_x = first_point.x;
     bounds.min_y = bounds.max_y = first_point.y;
     bounds.min_category = bounds.max_category = first_point.category;
     bounds.min_group_id = bounds.max_group_id = first_point.group_id;
     
     // Find bounds across all points
-    for (const auto& point : cached_points) {
+    for (const auto& point : *cached_points) {
         bounds.min_x = std::min(bounds.min_x, point.x);
         bounds.max_x = std::max(bounds.max_x, point.x);
         bounds.min_y = std::min(bounds.min_y, point.y);
@@ -227,6 +444,23 @@ DataBounds QueryEngine::getDataBounds() const {
     return bounds;
 }
 
+CropRequest QueryEngine::toCropRequest(const QuerySpec& query_spec) {
+    CropRequest request(query_spec.crop_query.region, query_spec.valid_region);
+    request.category_filter = query_spec.crop_query.category_filter;
+    request.group_filter = query_spec.crop_query.group_filter;
+    request.proper_constraint = query_spec.crop_query.proper;
+    request.limit = query_spec.crop_query.limit;
+    request.after = query_spec.crop_query.after;
+    return request;
+}
+
+DatabaseManager& QueryEngine::requireDatabase(const char* feature) {
+    if (!db_manager) {
+        throw std::runtime_error(std::string(feature) + " is not available in sharded mode");
+    }
+    return *db_manager;
+}
+
 void QueryEngine::validateQuery(const QuerySpec& query_spec) {
     // Validate valid region
     if (!query_spec.valid_region.isValid()) {
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
+#include "../backend/QueryBackend.h"
 #include "../database/DatabaseManager.h"
+#include "../geometry/ScanKernel.h"
+#include "../query/CategoryIndex.h"
+#include "../query/GroupIndex.h"
 #include "../query/JsonParser.h"
 #include "../query/QueryResult.h"
 
@@ -21,17 +26,33 @@ struct DataBounds {
  */
 class QueryEngine {
 private:
-    std::unique_ptr<DatabaseManager> db_manager;
+    std::unique_ptr<DatabaseManager> db_manager;  // Null in sharded mode
+    std::unique_ptr<QueryBackend> backend;        // Answers crop and aggregate queries
     bool test_mode;
-    std::vector<Point> cached_points;  // For brute force testing
+    PointRows::Table cached_points;    // For brute force testing; brute force results are rows of it
+    PointColumns cached_columns;       // Same points as columns, for the vectorized brute force scan
+    GroupIndex cached_groups;          // Points of each group, for brute force crops restricted to few groups
+    CategoryIndex cached_categories;   // Rows of each category, for category-filtered brute force crops
     
 public:
     /**
      * Initialize query engine with database connection
      * @param connection_string PostgreSQL connection string
      * @param test_mode If true, loads all points into memory for brute force testing
+     * @param pool_size Maximum number of database connections used concurrently
      */
-    explicit QueryEngine(const std::string& connection_string, bool test_mode = false);
+    explicit QueryEngine(const std::string& connection_string, bool test_mode = false, size_t pool_size = 4);
+    
+    /**
+     * Initialize query engine over a sharded deployment (see ShardedBackend)
+     * Crops are scattered to the shards that can contribute and the sorted
+     * partial results merged. Explain, batches, Morton ranges and parallel bands
+     * need a single database and are not available in this mode.
+     * @param shard_connection_strings One PostgreSQL connection string per shard
+     * @param test_mode If true, loads all points of all shards into memory for brute force testing
+     * @param pool_size Maximum number of database connections per shard
+     */
+    QueryEngine(const std::vector<std::string>& shard_connection_strings, bool test_mode = false, size_t pool_size = 4);
     
     /**
      * Destructor
@@ -56,12 +77,28 @@ public:
     
     /**
      * Execute a parsed query specification
+     * Safe to call from several threads at once; each call uses its own pooled connection
      * @param query_spec Parsed query specification
      * @return QueryResult containing matching points
      * @throws std::runtime_error on query execution errors
      */
     QueryResult executeQuery(const QuerySpec& query_spec);
     
+    /**
+     * Show how the database executes the crop part of a query
+     * @param query_spec Parsed query specification
+     * @return EXPLAIN (ANALYZE, BUFFERS) plan text
+     */
+    std::string explainQuery(const QuerySpec& query_spec);
+    
+    /**
+     * Execute several parsed queries as one pipelined database batch
+     * @param query_specs Parsed query specifications
+     * @return One QueryResult per query, in the same order (duration is that of the whole batch)
+     * @throws std::runtime_error on query execution errors
+     */
+    std::vector<QueryResult> executeQueryBatch(const std::vector<QuerySpec>& query_specs);
+    
     /**
      * Execute query using brute force approach for testing
      * @param query_spec Parsed query specification
@@ -71,7 +108,35 @@ public:
     QueryResult executeQueryBruteForce(const QuerySpec& query_spec);
     
     /**
-     * Test database connection
+     * Serve crop rectangles through Morton key range scans (see DatabaseManager::setMortonKeyRanges)
+     * @param max_ranges Maximum ranges per crop (0 disables)
+     */
+    void setMortonKeyRanges(size_t max_ranges);
+    
+    /**
+     * Split large crops into parallel y-bands (see DatabaseManager::setParallelBands)
+     * @param max_bands Maximum number of bands (1 disables)
+     * @param min_rows Only split crops estimated at this many rows or more
+     */
+    void setParallelBands(size_t max_bands, size_t min_rows = 50000);
+    
+    /**
+     * Choose the backend that answers crop and aggregate queries
+     * "database" runs SQL (the default); any in-memory backend name (e.g. "rtree")
+     * loads a snapshot of all points and builds that index over it. Explain and
+     * batches still go to the database.
+     * @param name Backend name
+     * @throws std::runtime_error on unknown names or in sharded mode
+     */
+    void selectBackend(const std::string& name);
+    
+    /**
+     * Name of the backend currently answering queries
+     */
+    std::string getBackendName() const { return backend->getName(); }
+    
+    /**
+     * Test database connection (every shard in sharded mode)
      * @return true if connection is working
      */
     bool testConnection();
@@ -88,4 +153,36 @@ private:
      * Validate query specification before execution
      */
     void validateQuery(const QuerySpec& query_spec);
+    
+    /**
+     * Convert a query specification into backend crop parameters
+     */
+    static CropRequest toCropRequest(const QuerySpec& query_spec);
+    
+    /**
+     * Get the single database, or throw in sharded mode
+     * @param feature Name of the feature that needs it (for the error message)
+     */
+    DatabaseManager& requireDatabase(const char* feature);
+    
+    /**
+     * Drop rows up to the "after" cursor and truncate to "limit" (rows must be sorted)
+     * @param table Points the rows index
+     * @param sorted_rows Ordinals into table in (y, x, id) order
+     */
+    static void applyKeysetWindow(const std::vector<Point>& table, std::vector<uint32_t>& sorted_rows,
+                                  const CropQuery& crop_query);
+    
+    /**
+     * Wrap the rows of a brute force query into its result (aggregated for aggregate output modes)
+     * @param result_points Matching rows in (y, x, id) order, already windowed
+     * @param query_start When the query started, for the duration
+     */
+    static QueryResult bruteForceResult(PointRows result_points, const QuerySpec& query_spec,
+                                        std::chrono::high_resolution_clock::time_point query_start);
+    
+    /**
+     * Record the next-page cursor on a result whose page is full
+     */
+    static void setNextCursor(QueryResult& result, const CropQuery& crop_query);
 };
\ No newline at end of file
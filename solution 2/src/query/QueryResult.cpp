@@ -6,7 +6,23 @@
 #include <set>
 #include <algorithm>
 
-QueryResult::QueryResult(const std::vector<Point>& result_points) : points(result_points) {
+QueryResult::QueryResult(std::vector<Point> result_points) : rows(std::move(result_points)) {
+}
+
+QueryResult::QueryResult(PointRows result_rows) : rows(std::move(result_rows)) {
+}
+
+QueryResult::QueryResult(const AggregateResult& aggregate_result) : aggregate(aggregate_result) {
+}
+
+const std::vector<Point>& QueryResult::getPoints() const {
+    if (rows.coversTable()) {
+        return *rows.getTable();
+    }
+    if (!gathered) {
+        gathered = rows.materialize();
+    }
+    return *gathered;
 }
 
 void QueryResult::writeToFile(const std::string& filename) const {
@@ -15,40 +31,79 @@ void QueryResult::writeToFile(const std::string& filename) const {
         throw std::runtime_error("Could not open output file: " + filename);
     }
     
-    // Write points in "x y" format, one per line
+    if (aggregate) {
+        switch (aggregate->mode) {
+            case OutputMode::PerCategory:
+            case OutputMode::PerGroup:
+                for (const auto& [key, count] : aggregate->buckets) {
+                    file << key << " " << count << std::endl;
+                }
+                break;
+            case OutputMode::BoundingBox:
+                if (aggregate->bounding_box) {
+                    const Rectangle& box = *aggregate->bounding_box;
+                    file << std::fixed << std::setprecision(6)
+                         << box.p_min.x << " " << box.p_min.y << " "
+                         << box.p_max.x << " " << box.p_max.y << std::endl;
+                }
+                break;
+            default:
+                file << aggregate->count << std::endl;
+                break;
+        }
+        
+        std::cout << "Results written to: " << filename << " (" << outputModeName(aggregate->mode)
+                  << " of " << aggregate->count << " points)" << std::endl;
+        return;
+    }
+    
+    // Write points in "x y" format, one per line, reading each row from its table
     // Points are already sorted by (y, x)
-    for (const Point& point : points) {
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const Point& point = rows[i];
         file << std::fixed << std::setprecision(6) 
              << point.x << " " << point.y << std::endl;
     }
     
     file.close();
     
-    std::cout << "Results written to: " << filename << " (" << points.size() << " points)" << std::endl;
+    std::cout << "Results written to: " << filename << " (" << rows.size() << " points)" << std::endl;
 }
 
 std::string QueryResult::toString() const {
     std::ostringstream oss;
     
-    oss << "Query Results (" << points.size() << " points):\n";
+    if (aggregate) {
+        oss << "Query Results (" << outputModeName(aggregate->mode) << " of "
+            << aggregate->count << " points)\n";
+        for (const auto& [key, count] : aggregate->buckets) {
+            oss << "  " << key << ": " << count << "\n";
+        }
+        if (aggregate->bounding_box) {
+            oss << "  " << aggregate->bounding_box->toString() << "\n";
+        }
+        return oss.str();
+    }
+    
+    oss << "Query Results (" << rows.size() << " points):\n";
     
-    if (points.empty()) {
+    if (rows.empty()) {
         oss << "  (no points found)\n";
         return oss.str();
     }
     
     // Show first few points for preview
-    size_t preview_count = std::min(size_t(10), points.size());
+    size_t preview_count = std::min(size_t(10), rows.size());
     
     for (size_t i = 0; i < preview_count; ++i) {
-        const Point& p = points[i];
+        const Point& p = rows[i];
         oss << "  " << std::fixed << std::setprecision(2) 
             << p.x << " " << p.y 
             << " (id=" << p.id << ", group=" << p.group_id << ", cat=" << p.category << ")\n";
     }
     
-    if (points.size() > preview_count) {
-        oss << "  ... and " << (points.size() - preview_count) << " more points\n";
+    if (rows.size() > preview_count) {
+        oss << "  ... and " << (rows.size() - preview_count) << " more points\n";
     }
     
     return oss.str();
@@ -56,12 +111,28 @@ std::string QueryResult::toString() const {
 
 void QueryResult::printSummary() const {
     std::cout << "\n=== Query Results Summary ===" << std::endl;
-    std::cout << "Total points found: " << points.size() << std::endl;
+    std::cout << "Total points found: " << size() << std::endl;
     if (query_duration_ms > 0) {
         std::cout << "Query execution time: " << query_duration_ms << " ms" << std::endl;
     }
     
-    if (points.empty()) {
+    // Aggregates were computed by the database; just report them
+    if (aggregate) {
+        std::cout << "Output mode: " << outputModeName(aggregate->mode) << std::endl;
+        if (aggregate->mode == OutputMode::PerCategory || aggregate->mode == OutputMode::PerGroup) {
+            std::cout << (aggregate->mode == OutputMode::PerCategory ? "Categories" : "Groups")
+                      << " with matches: " << aggregate->buckets.size() << std::endl;
+        }
+        if (aggregate->bounding_box) {
+            const Rectangle& box = *aggregate->bounding_box;
+            std::cout << "Bounding box: [(" << std::fixed << std::setprecision(2)
+                      << box.p_min.x << "," << box.p_min.y << ") - ("
+                      << box.p_max.x << "," << box.p_max.y << ")]" << std::endl;
+        }
+        return;
+    }
+    
+    if (rows.empty()) {
         std::cout << "No points matched the query criteria." << std::endl;
         return;
     }
@@ -69,10 +140,11 @@ void QueryResult::printSummary() const {
     // Calculate some basic statistics
     std::set<long long> unique_groups;
     std::set<int> unique_categories;
-    double min_x = points[0].x, max_x = points[0].x;
-    double min_y = points[0].y, max_y = points[0].y;
+    double min_x = rows[0].x, max_x = rows[0].x;
+    double min_y = rows[0].y, max_y = rows[0].y;
     
-    for (const Point& p : points) {
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const Point& p = rows[i];
         unique_groups.insert(p.group_id);
         unique_categories.insert(p.category);
         min_x = std::min(min_x, p.x);
@@ -2,21 +2,37 @@
 
 #include <vector>
 #include <string>
+#include <optional>
 #include "../geometry/Point.h"
+#include "AggregateResult.h"
+#include "PointRows.h"
 
 /**
  * Query result container and output formatter
  */
 class QueryResult {
 private:
-    std::vector<Point> points;
+    PointRows rows;
+    mutable std::optional<std::vector<Point>> gathered;  // getPoints() copy of rows that are not a whole table
+    std::optional<AggregateResult> aggregate;  // Set instead of points for aggregate output modes
+    std::optional<KeysetCursor> next_cursor;   // Set when a limited page is full and more may follow
     long long query_duration_ms = 0;  // Query execution time in milliseconds
     
 public:
     /**
-     * Constructor with points
+     * Constructor with points (move them in to avoid a copy)
      */
-    explicit QueryResult(const std::vector<Point>& result_points);
+    explicit QueryResult(std::vector<Point> result_points);
+    
+    /**
+     * Constructor with rows of a shared table; points are gathered only when read
+     */
+    explicit QueryResult(PointRows result_rows);
+    
+    /**
+     * Constructor with an aggregate (count, per_category, per_group or bbox output)
+     */
+    explicit QueryResult(const AggregateResult& aggregate_result);
     
     /**
      * Default constructor
@@ -25,18 +41,44 @@ public:
     
     /**
      * Get the points in the result
+     * Rows that select from a shared table are gathered on the first call.
      */
-    const std::vector<Point>& getPoints() const { return points; }
+    const std::vector<Point>& getPoints() const;
     
     /**
-     * Get number of points in result
+     * Get the result rows without gathering them
      */
-    size_t size() const { return points.size(); }
+    const PointRows& getRows() const { return rows; }
+    
+    /**
+     * Check whether this result holds an aggregate instead of points
+     */
+    bool isAggregate() const { return aggregate.has_value(); }
+    
+    /**
+     * Get the aggregate (only valid if isAggregate())
+     */
+    const AggregateResult& getAggregate() const { return *aggregate; }
+    
+    /**
+     * Get number of matching points (the aggregate count for aggregate results)
+     */
+    size_t size() const { return aggregate ? aggregate->count : rows.size(); }
     
     /**
      * Check if result is empty
      */
-    bool empty() const { return points.empty(); }
+    bool empty() const { return size() == 0; }
+    
+    /**
+     * Set the cursor for fetching the next page (pass as "after" in the next query)
+     */
+    void setNextCursor(const KeysetCursor& cursor) { next_cursor = cursor; }
+    
+    /**
+     * Get the cursor for the next page, if the page was full
+     */
+    const std::optional<KeysetCursor>& getNextCursor() const { return next_cursor; }
     
     /**
      * Set query execution duration
@@ -54,6 +96,7 @@ public:
      * Write results to output file
      * Format: Each line contains "x y" (space-separated coordinates)
      * Points are already sorted by (y, x)
+     * Aggregates are written as "count", "key count" lines, or "min_x min_y max_x max_y"
      * 
      * @param filename Output file path
      * @throws std::runtime_error on file I/O errors
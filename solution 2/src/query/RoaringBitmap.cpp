@@ -0,0 +1,93 @@
+#include "RoaringBitmap.h"
+#include <algorithm>
+
+RoaringBitmap::RoaringBitmap(const std::vector<uint32_t>& rows) : members(rows.size()) {
+    for (size_t begin = 0; begin < rows.size();) {
+        uint32_t key = rows[begin] >> 16;
+        size_t end = begin;
+        while (end < rows.size() && (rows[end] >> 16) == key) {
+            ++end;
+        }
+        
+        Chunk chunk{key, {}, {}};
+        if (end - begin <= ARRAY_MAX) {
+            chunk.array.reserve(end - begin);
+            for (size_t i = begin; i < end; ++i) {
+                chunk.array.push_back(static_cast<uint16_t>(rows[i]));
+            }
+        } else {
+            chunk.bits.assign(CHUNK_ROWS / 64, 0);
+            for (size_t i = begin; i < end; ++i) {
+                uint16_t low = static_cast<uint16_t>(rows[i]);
+                chunk.bits[low / 64] |= uint64_t(1) << (low % 64);
+            }
+        }
+        chunks.push_back(std::move(chunk));
+        begin = end;
+    }
+}
+
+bool RoaringBitmap::contains(uint32_t row) const {
+    uint32_t key = row >> 16;
+    auto chunk = std::lower_bound(chunks.begin(), chunks.end(), key,
+                                  [](const Chunk& c, uint32_t k) { return c.key < k; });
+    if (chunk == chunks.end() || chunk->key != key) {
+        return false;
+    }
+    
+    uint16_t low = static_cast<uint16_t>(row);
+    if (!chunk->bits.empty()) {
+        return (chunk->bits[low / 64] >> (low % 64) & 1) != 0;
+    }
+    return std::binary_search(chunk->array.begin(), chunk->array.end(), low);
+}
+
+void RoaringBitmap::orMask(size_t first, size_t count, uint64_t* mask) const {
+    if (count == 0) {
+        return;
+    }
+    size_t last = first + count;
+    auto chunk = std::lower_bound(chunks.begin(), chunks.end(), first >> 16,
+                                  [](const Chunk& c, size_t k) { return c.key < k; });
+    
+    for (; chunk != chunks.end() && (size_t(chunk->key) << 16) < last; ++chunk) {
+        size_t base = size_t(chunk->key) << 16;
+        size_t low = std::max(first, base) - base;      // Chunk-relative [low, high)
+        size_t high = std::min(last, base + CHUNK_ROWS) - base;
+        
+        if (!chunk->bits.empty() && first % 64 == 0) {
+            // Chunks start on word boundaries, so with an aligned range whole words line up
+            for (size_t w = low / 64; w * 64 < high; ++w) {
+                uint64_t word = chunk->bits[w];
+                if (high - w * 64 < 64) {
+                    word &= (uint64_t(1) << (high - w * 64)) - 1;
+                }
+                mask[(base + w * 64 - first) / 64] |= word;
+            }
+        } else if (!chunk->bits.empty()) {
+            for (size_t w = low / 64; w * 64 < high; ++w) {
+                for (uint64_t bits = chunk->bits[w]; bits != 0; bits &= bits - 1) {
+                    size_t row = w * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+                    if (row >= low && row < high) {
+                        size_t bit = base + row - first;
+                        mask[bit / 64] |= uint64_t(1) << (bit % 64);
+                    }
+                }
+            }
+        } else {
+            auto it = std::lower_bound(chunk->array.begin(), chunk->array.end(), low);
+            for (; it != chunk->array.end() && *it < high; ++it) {
+                size_t bit = base + *it - first;
+                mask[bit / 64] |= uint64_t(1) << (bit % 64);
+            }
+        }
+    }
+}
+
+size_t RoaringBitmap::memoryUsage() const {
+    size_t bytes = chunks.capacity() * sizeof(Chunk);
+    for (const auto& chunk : chunks) {
+        bytes += chunk.array.capacity() * sizeof(uint16_t) + chunk.bits.capacity() * sizeof(uint64_t);
+    }
+    return bytes;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Compressed set of 32-bit row ordinals in the style of Roaring bitmaps
+ *
+ * Ordinals are split by their high 16 bits into chunks of 65536 rows. Each
+ * chunk that has members stores them either as a sorted array of the low 16
+ * bits (up to ARRAY_MAX members, 2 bytes each) or, when denser, as a
+ * 65536-bit bitset (8 KiB), whichever is smaller. Rare values cost a few
+ * bytes per member, common ones one bit per row, and both turn into
+ * selection bitmask words (see ScanKernel) for any range of rows.
+ */
+class RoaringBitmap {
+public:
+    static constexpr size_t CHUNK_ROWS = 65536;
+    static constexpr size_t ARRAY_MAX = 4096;     // Above this an array is larger than the bitset
+    
+    RoaringBitmap() = default;
+    
+    /**
+     * Build from ordinals
+     * @param rows Ordinals in ascending order, without duplicates
+     */
+    explicit RoaringBitmap(const std::vector<uint32_t>& rows);
+    
+    /**
+     * Number of members
+     */
+    size_t cardinality() const { return members; }
+    
+    bool contains(uint32_t row) const;
+    
+    /**
+     * Set the mask bits of the members in [first, first + count)
+     * @param first First row of the range
+     * @param count Number of rows
+     * @param mask Selection mask, ScanKernel::maskWords(count) words; bit i stands for row first + i
+     */
+    void orMask(size_t first, size_t count, uint64_t* mask) const;
+    
+    /**
+     * Heap memory held, in bytes
+     */
+    size_t memoryUsage() const;
+    
+private:
+    /**
+     * Members of one chunk: array when bits is empty, bitset otherwise
+     */
+    struct Chunk {
+        uint32_t key;                   // High 16 bits of the chunk's ordinals
+        std::vector<uint16_t> array;    // Sorted low 16 bits
+        std::vector<uint64_t> bits;     // CHUNK_ROWS / 64 words
+    };
+    
+    std::vector<Chunk> chunks;          // Ascending key, only chunks with members
+    size_t members = 0;
+};
\ No newline at end of file
@@ -1,8 +1,23 @@
 #include <gtest/gtest.h>
 #include "src/query/QueryEngine.h"
 #include "src/query/JsonParser.h"
+#include "src/backend/InMemoryBackend.h"
+#include "src/backend/MorselScheduler.h"
+#include "src/query/PointSort.h"
+#include "src/backend/ZoneMap.h"
+#include "src/query/GroupIndex.h"
+#include "src/query/CategoryIndex.h"
 #include <vector>
 #include <string>
+#include <atomic>
+#include <stdexcept>
+#include <future>
+#include <thread>
+#include <cstdlib>
+#include <sstream>
+#include <algorithm>
+#include <random>
+#include <cmath>
 
 class QueryEngineTest : public ::testing::Test {
 protected:
@@ -42,6 +57,53 @@ protected:
         }
     }
 
+    void compareAggregateResults(const QueryResult& db_result, const QueryResult& bf_result) {
+        ASSERT_TRUE(db_result.isAggregate());
+        ASSERT_TRUE(bf_result.isAggregate());
+        
+        const AggregateResult& db_agg = db_result.getAggregate();
+        const AggregateResult& bf_agg = bf_result.getAggregate();
+        
+        EXPECT_EQ(db_agg.count, bf_agg.count) << "Aggregate count mismatch";
+        EXPECT_EQ(db_agg.buckets, bf_agg.buckets) << "Per-key counts mismatch";
+        ASSERT_EQ(db_agg.bounding_box.has_value(), bf_agg.bounding_box.has_value());
+        if (db_agg.bounding_box) {
+            EXPECT_DOUBLE_EQ(db_agg.bounding_box->p_min.x, bf_agg.bounding_box->p_min.x);
+            EXPECT_DOUBLE_EQ(db_agg.bounding_box->p_min.y, bf_agg.bounding_box->p_min.y);
+            EXPECT_DOUBLE_EQ(db_agg.bounding_box->p_max.x, bf_agg.bounding_box->p_max.x);
+            EXPECT_DOUBLE_EQ(db_agg.bounding_box->p_max.y, bf_agg.bounding_box->p_max.y);
+        }
+    }
+
+    void testBackend(const std::string& backend_name) {
+        // Same crop shapes as the database tests, plus paging, so every backend sees every filter
+        std::vector<std::string> queries = {
+            R"({"valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+                "query": {"operator_crop": {"region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}}}}})",
+            R"({"valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+                "query": {"operator_crop": {"region": {"p_min": {"x": 412.5, "y": 87.25}, "p_max": {"x": 431.0, "y": 99.5}}}}})",
+            R"({"valid_region": {"p_min": {"x": 100, "y": 100}, "p_max": {"x": 800, "y": 900}},
+                "query": {"operator_crop": {"region": {"p_min": {"x": 50, "y": 20}, "p_max": {"x": 700, "y": 650}},
+                                            "category": 1, "proper": true}}})",
+            R"({"valid_region": {"p_min": {"x": 100, "y": 100}, "p_max": {"x": 800, "y": 900}},
+                "query": {"operator_crop": {"region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+                                            "proper": false, "limit": 50, "after": {"y": 300.0, "x": 0, "id": 0}}}})",
+            R"({"valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+                "query": {"operator_crop": {"region": {"p_min": {"x": 0, "y": 400}, "p_max": {"x": 1000, "y": 420}},
+                                            "one_of_groups": [0, 1, 2, 3, 5, 8]}}})",
+            R"({"valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+                "query": {"operator_crop": {"region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}}}},
+                "output": "per_category"})"
+        };
+        
+        engine->selectBackend(backend_name);
+        EXPECT_EQ(engine->getBackendName(), backend_name);
+        for (size_t i = 0; i < queries.size(); ++i) {
+            testQuery(backend_name + "_" + std::to_string(i), queries[i]);
+        }
+        engine->selectBackend("database");
+    }
+
     void testQuery(const std::string& test_name, const std::string& query_json) {
         std::cout << "\n=== Testing: " << test_name << " ===" << std::endl;
         
@@ -56,7 +118,11 @@ protected:
         std::cout << "Brute force timing: " << bf_result.getQueryDuration() << " ms" << std::endl;
         
         // Compare results
-        compareQueryResults(db_result, bf_result);
+        if (query_spec.output_mode == OutputMode::Points) {
+            compareQueryResults(db_result, bf_result);
+        } else {
+            compareAggregateResults(db_result, bf_result);
+        }
     }
 
     std::string connection_string;
@@ -262,6 +328,706 @@ TEST_F(QueryEngineTest, SmallValidRegionVsLargeCrop) {
     testQuery("Small Valid Region vs Large Crop", query_json);
 }
 
+TEST_F(QueryEngineTest, AggregateOutputModes) {
+    for (const std::string mode : {"count", "per_category", "per_group", "bbox"}) {
+        std::string query_json = R"({
+            "valid_region": {
+                "p_min": {"x": 100, "y": 100},
+                "p_max": {"x": 900, "y": 900}
+            },
+            "query": {
+                "operator_crop": {
+                    "region": {
+                        "p_min": {"x": 150, "y": 200},
+                        "p_max": {"x": 750, "y": 800}
+                    },
+                    "proper": false
+                }
+            },
+            "output": ")" + mode + R"("
+        })";
+        
+        testQuery("Aggregate Output: " + mode, query_json);
+    }
+}
+
+TEST_F(QueryEngineTest, KeysetPagination) {
+    QuerySpec full_spec = JsonParser::parseQueryString(R"({
+        "valid_region": {
+            "p_min": {"x": 0, "y": 0},
+            "p_max": {"x": 1000, "y": 1000}
+        },
+        "query": {
+            "operator_crop": {
+                "region": {
+                    "p_min": {"x": 100, "y": 100},
+                    "p_max": {"x": 700, "y": 700}
+                },
+                "category": 1
+            }
+        }
+    })");
+    QueryResult full_result = engine->executeQueryBruteForce(full_spec);
+    
+    // Walk all pages following the returned cursor
+    QuerySpec page_spec = full_spec;
+    page_spec.crop_query.limit = 37;
+    std::vector<Point> paged_points;
+    
+    while (true) {
+        QueryResult page = engine->executeQuery(page_spec);
+        ASSERT_LE(page.size(), 37u);
+        paged_points.insert(paged_points.end(), page.getPoints().begin(), page.getPoints().end());
+        
+        if (!page.getNextCursor().has_value()) {
+            break;
+        }
+        page_spec.crop_query.after = page.getNextCursor();
+    }
+    
+    compareQueryResults(QueryResult(paged_points), full_result);
+}
+
+TEST_F(QueryEngineTest, ConcurrentQueries) {
+    // Queries share one engine (and its connection pool) across threads
+    std::vector<QuerySpec> specs;
+    for (int i = 0; i < 8; ++i) {
+        double offset = 100.0 * i;
+        CropQuery crop(Rectangle(offset, 0, offset + 300, 1000));
+        if (i % 2 == 1) {
+            crop.proper = true;
+        }
+        specs.emplace_back(Rectangle(0, 0, 1000, 1000), crop);
+    }
+    
+    std::vector<std::future<QueryResult>> pending;
+    for (const auto& spec : specs) {
+        pending.push_back(std::async(std::launch::async, [this, &spec]() {
+            return engine->executeQuery(spec);
+        }));
+    }
+    
+    for (size_t i = 0; i < specs.size(); ++i) {
+        QueryResult db_result = pending[i].get();
+        QueryResult bf_result = engine->executeQueryBruteForce(specs[i]);
+        compareQueryResults(db_result, bf_result);
+    }
+}
+
+TEST_F(QueryEngineTest, PoolAcquireTimeout) {
+    // Another thread keeps releasing and re-taking the only connection: every release wakes the waiter,
+    // which finds nothing, yet the timeout still counts from the start of acquire()
+    ConnectionPool pool(connection_string, 1, std::chrono::seconds(30), std::chrono::milliseconds(200));
+    std::atomic<bool> stop{false};
+    auto hog = std::async(std::launch::async, [&]() {
+        while (!stop) {
+            auto handle = pool.acquire();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    
+    auto start = std::chrono::steady_clock::now();
+    try {
+        auto handle = pool.acquire();
+    } catch (const std::runtime_error&) {
+        // Timing out is expected; waiting well past the timeout is not
+    }
+    auto waited = std::chrono::steady_clock::now() - start;
+    stop = true;
+    hog.get();
+    
+    EXPECT_LT(waited, std::chrono::milliseconds(350));
+}
+
+TEST_F(QueryEngineTest, PipelinedBatchQueries) {
+    // Mix of plain, filtered, proper and improper crops sharing two valid regions
+    std::vector<QuerySpec> specs;
+    for (int i = 0; i < 12; ++i) {
+        double offset = 75.0 * i;
+        CropQuery crop(Rectangle(offset, offset / 2, offset + 250, offset / 2 + 400));
+        if (i % 3 == 1) {
+            crop.category_filter = {i % 2};
+        }
+        if (i % 4 == 2) {
+            crop.proper = (i % 8 == 2);
+        }
+        Rectangle valid = (i % 2 == 0) ? Rectangle(0, 0, 1000, 1000) : Rectangle(100, 100, 900, 900);
+        specs.emplace_back(valid, crop);
+    }
+    
+    std::vector<QueryResult> batch_results = engine->executeQueryBatch(specs);
+    ASSERT_EQ(batch_results.size(), specs.size());
+    
+    for (size_t i = 0; i < specs.size(); ++i) {
+        QueryResult bf_result = engine->executeQueryBruteForce(specs[i]);
+        compareQueryResults(batch_results[i], bf_result);
+    }
+}
+
+TEST_F(QueryEngineTest, MortonKeyRanges) {
+    // Coarse and fine decompositions must return exactly the same points
+    std::vector<std::string> queries = {
+        R"({"valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+            "query": {"operator_crop": {"region": {"p_min": {"x": 120.5, "y": 80.25}, "p_max": {"x": 610.75, "y": 433.0}}}}})",
+        R"({"valid_region": {"p_min": {"x": 100, "y": 100}, "p_max": {"x": 800, "y": 900}},
+            "query": {"operator_crop": {"region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+                                        "category": 1, "proper": true}}})",
+        R"({"valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+            "query": {"operator_crop": {"region": {"p_min": {"x": 333.3, "y": 333.3}, "p_max": {"x": 333.4, "y": 900}}}}})"
+    };
+    
+    for (size_t max_ranges : {1, 4, 16, 256}) {
+        engine->setMortonKeyRanges(max_ranges);
+        for (size_t i = 0; i < queries.size(); ++i) {
+            testQuery("MortonKeyRanges_" + std::to_string(max_ranges) + "_" + std::to_string(i), queries[i]);
+        }
+    }
+    engine->setMortonKeyRanges(0);
+}
+
+TEST_F(QueryEngineTest, ParallelBandCrop) {
+    // Force splitting regardless of size; results must match the single-statement brute force
+    engine->setParallelBands(4, 0);
+    
+    testQuery("ParallelBandCrop_Full", R"({
+        "valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+        "query": {"operator_crop": {"region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}}}}
+    })");
+    testQuery("ParallelBandCrop_Filtered", R"({
+        "valid_region": {"p_min": {"x": 50, "y": 50}, "p_max": {"x": 950, "y": 950}},
+        "query": {"operator_crop": {"region": {"p_min": {"x": 10.5, "y": 3.25}, "p_max": {"x": 870, "y": 990.5}},
+                                    "category": 1, "proper": false}}
+    })");
+    testQuery("ParallelBandCrop_AfterCursor", R"({
+        "valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+        "query": {"operator_crop": {"region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+                                    "after": {"y": 400.0, "x": 0, "id": 0}}}
+    })");
+    
+    // Several banded crops at once ask for more connections than the pool holds; they must not wait on each other
+    std::vector<QuerySpec> specs;
+    for (int i = 0; i < 6; ++i) {
+        specs.emplace_back(Rectangle(0, 0, 1000, 1000), CropQuery(Rectangle(50.0 * i, 0, 50.0 * i + 600, 1000)));
+    }
+    std::vector<std::future<QueryResult>> pending;
+    for (const auto& spec : specs) {
+        pending.push_back(std::async(std::launch::async, [this, &spec]() {
+            return engine->executeQuery(spec);
+        }));
+    }
+    for (size_t i = 0; i < specs.size(); ++i) {
+        QueryResult db_result = pending[i].get();
+        compareQueryResults(db_result, engine->executeQueryBruteForce(specs[i]));
+    }
+    
+    engine->setParallelBands(1);
+}
+
+TEST_F(QueryEngineTest, GroupExtentTracksUpdates) {
+    // All changes happen in one transaction that is rolled back, so the dataset is untouched
+    pqxx::connection conn(connection_string);
+    pqxx::work txn(conn);
+    
+    pqxx::result group = txn.exec("SELECT group_id, max_x, point_count FROM group_extent ORDER BY group_id LIMIT 1");
+    ASSERT_EQ(group.size(), 1u) << "group_extent is empty; recreate the schema and reload the data";
+    long long group_id = group[0][0].as<long long>();
+    double max_x = group[0][1].as<double>();
+    long long point_count = group[0][2].as<long long>();
+    
+    auto extentMatchesPoints = [&]() {
+        pqxx::result check = txn.exec(
+            "SELECT e.min_x = a.min_x AND e.max_x = a.max_x AND e.min_y = a.min_y AND e.max_y = a.max_y "
+            "AND e.point_count = a.n FROM group_extent e, "
+            "(SELECT MIN(coord_x) AS min_x, MAX(coord_x) AS max_x, MIN(coord_y) AS min_y, "
+            "MAX(coord_y) AS max_y, COUNT(*) AS n FROM inspection_region WHERE group_id = " +
+            std::to_string(group_id) + ") a WHERE e.group_id = " + std::to_string(group_id));
+        return check.size() == 1 && check[0][0].as<bool>();
+    };
+    
+    // Insert grows the extent
+    txn.exec("INSERT INTO inspection_region (id, group_id, coord_x, coord_y, category) "
+             "SELECT MAX(id) + 1, " + std::to_string(group_id) + ", " + std::to_string(max_x + 1000.0) +
+             ", 0, 0 FROM inspection_region");
+    pqxx::result grown = txn.exec("SELECT max_x, point_count FROM group_extent WHERE group_id = " + std::to_string(group_id));
+    EXPECT_DOUBLE_EQ(grown[0][0].as<double>(), max_x + 1000.0);
+    EXPECT_EQ(grown[0][1].as<long long>(), point_count + 1);
+    EXPECT_TRUE(extentMatchesPoints());
+    
+    // Update moves the outlier back inside; delete removes it again
+    txn.exec("UPDATE inspection_region SET coord_x = " + std::to_string(max_x) +
+             " WHERE id = (SELECT MAX(id) FROM inspection_region)");
+    EXPECT_TRUE(extentMatchesPoints());
+    
+    txn.exec("DELETE FROM inspection_region WHERE id = (SELECT MAX(id) FROM inspection_region)");
+    EXPECT_TRUE(extentMatchesPoints());
+    
+    txn.abort();
+}
+
+TEST_F(QueryEngineTest, GroupExtentConcurrentDeletes) {
+    // A fresh group with three points; two connections each delete one of them at the same time
+    pqxx::connection setup_conn(connection_string);
+    long long group_id;
+    long long first_id;
+    {
+        pqxx::work txn(setup_conn);
+        group_id = txn.exec("SELECT COALESCE(MAX(id), 0) + 1 FROM inspection_group")[0][0].as<long long>();
+        first_id = txn.exec("SELECT COALESCE(MAX(id), 0) + 1 FROM inspection_region")[0][0].as<long long>();
+        txn.exec("INSERT INTO inspection_group (id) VALUES (" + std::to_string(group_id) + ")");
+        txn.exec("INSERT INTO inspection_region (id, group_id, coord_x, coord_y, category) VALUES (" +
+                 std::to_string(first_id) + ", " + std::to_string(group_id) + ", 10, 10, 0), (" +
+                 std::to_string(first_id + 1) + ", " + std::to_string(group_id) + ", 20, 20, 0), (" +
+                 std::to_string(first_id + 2) + ", " + std::to_string(group_id) + ", 30, 30, 0)");
+        txn.commit();
+    }
+    
+    pqxx::connection first_conn(connection_string);
+    pqxx::work first_txn(first_conn);
+    first_txn.exec("DELETE FROM inspection_region WHERE id = " + std::to_string(first_id));
+    
+    // The second delete waits on the first transaction's lock on the group's extent row
+    auto second = std::async(std::launch::async, [&]() {
+        pqxx::connection second_conn(connection_string);
+        pqxx::work second_txn(second_conn);
+        second_txn.exec("DELETE FROM inspection_region WHERE id = " + std::to_string(first_id + 2));
+        second_txn.commit();
+    });
+    EXPECT_EQ(second.wait_for(std::chrono::milliseconds(200)), std::future_status::timeout);
+    first_txn.commit();
+    EXPECT_NO_THROW(second.get());
+    
+    // Only the middle point is left, and the extent reflects both deletes
+    {
+        pqxx::work txn(setup_conn);
+        pqxx::result extent = txn.exec("SELECT min_x, max_x, min_y, max_y, point_count FROM group_extent "
+                                       "WHERE group_id = " + std::to_string(group_id));
+        ASSERT_EQ(extent.size(), 1u);
+        EXPECT_DOUBLE_EQ(extent[0][0].as<double>(), 20.0);
+        EXPECT_DOUBLE_EQ(extent[0][1].as<double>(), 20.0);
+        EXPECT_DOUBLE_EQ(extent[0][2].as<double>(), 20.0);
+        EXPECT_DOUBLE_EQ(extent[0][3].as<double>(), 20.0);
+        EXPECT_EQ(extent[0][4].as<long long>(), 1);
+        
+        txn.exec("DELETE FROM inspection_region WHERE group_id = " + std::to_string(group_id));
+        EXPECT_TRUE(txn.exec("SELECT 1 FROM group_extent WHERE group_id = " + std::to_string(group_id)).empty());
+        txn.exec("DELETE FROM inspection_group WHERE id = " + std::to_string(group_id));
+        txn.commit();
+    }
+}
+
+TEST_F(QueryEngineTest, ShardedMatchesSingle) {
+    // Needs the same dataset loaded into shards, e.g. docker-db.sh shards, then
+    // data_loader --shards=... and INSPECTION_SHARDS set to the same list
+    const char* shard_list = std::getenv("INSPECTION_SHARDS");
+    if (shard_list == nullptr || *shard_list == '\0') {
+        GTEST_SKIP() << "INSPECTION_SHARDS not set";
+    }
+    
+    std::vector<std::string> shards;
+    std::stringstream stream(shard_list);
+    std::string shard;
+    while (std::getline(stream, shard, ',')) {
+        shards.push_back(shard);
+    }
+    QueryEngine sharded_engine(shards);
+    
+    std::vector<std::string> queries = {
+        R"({"valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+            "query": {"operator_crop": {"region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}}}}})",
+        R"({"valid_region": {"p_min": {"x": 100, "y": 100}, "p_max": {"x": 800, "y": 900}},
+            "query": {"operator_crop": {"region": {"p_min": {"x": 50, "y": 20}, "p_max": {"x": 700, "y": 650}},
+                                        "category": 1, "proper": true}}})",
+        R"({"valid_region": {"p_min": {"x": 100, "y": 100}, "p_max": {"x": 800, "y": 900}},
+            "query": {"operator_crop": {"region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+                                        "proper": false, "limit": 50, "after": {"y": 300.0, "x": 0, "id": 0}}}})",
+        R"({"valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+            "query": {"operator_crop": {"region": {"p_min": {"x": 200, "y": 200}, "p_max": {"x": 600, "y": 600}},
+                                        "one_of_groups": [0, 1, 2, 3, 5, 8]}}})",
+        R"({"valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+            "query": {"operator_crop": {"region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}}}},
+            "output": "per_group"})"
+    };
+    
+    for (const auto& query : queries) {
+        QuerySpec query_spec = JsonParser::parseQueryString(query);
+        QueryResult sharded_result = sharded_engine.executeQuery(query_spec);
+        QueryResult bf_result = engine->executeQueryBruteForce(query_spec);
+        
+        if (query_spec.output_mode == OutputMode::Points) {
+            compareQueryResults(sharded_result, bf_result);
+            EXPECT_EQ(sharded_result.getNextCursor().has_value(), bf_result.getNextCursor().has_value());
+        } else {
+            compareAggregateResults(sharded_result, bf_result);
+        }
+    }
+    
+    // A point of a new group far outside the loaded data, written after the engine started, must still be routed to
+    pqxx::connection shard_conn(shards[0]);
+    {
+        pqxx::work txn(shard_conn);
+        txn.exec("INSERT INTO inspection_region (id, group_id, coord_x, coord_y, category) VALUES (-1, -1, 5000, 5000, 0)");
+        txn.commit();
+    }
+    for (const char* groups : {"", R"(, "one_of_groups": [-1])"}) {
+        QuerySpec late_spec = JsonParser::parseQueryString(std::string(R"({
+            "valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 10000, "y": 10000}},
+            "query": {"operator_crop": {"region": {"p_min": {"x": 4000, "y": 4000}, "p_max": {"x": 6000, "y": 6000}})") +
+            groups + "}}}");
+        std::vector<Point> late = sharded_engine.executeQuery(late_spec).getPoints();
+        EXPECT_EQ(late.size(), 1u) << groups;
+        EXPECT_TRUE(late.empty() || late[0].id == -1) << groups;
+    }
+    {
+        pqxx::work txn(shard_conn);
+        txn.exec("DELETE FROM inspection_region WHERE id = -1");
+        txn.commit();
+    }
+}
+
+TEST_F(QueryEngineTest, RTreeBackend) {
+    testBackend("rtree");
+    
+    // An empty table builds a tree without levels; crops must come back empty instead of reading a missing root
+    std::vector<Point> no_points;
+    std::unique_ptr<InMemoryBackend> empty = createInMemoryBackend("rtree", no_points);
+    CropRequest request(Rectangle(0, 0, 1000, 1000), Rectangle(0, 0, 1000, 1000));
+    EXPECT_TRUE(empty->executeCrop(request).empty());
+    request.category_filter = {1};
+    request.proper_constraint = false;
+    EXPECT_TRUE(empty->executeCrop(request).empty());
+    EXPECT_EQ(empty->executeAggregate(request, OutputMode::Count).count, 0u);
+}
+
+TEST_F(QueryEngineTest, ColumnarBackend) {
+    testBackend("columnar");
+}
+
+TEST_F(QueryEngineTest, CompressedBackend) {
+    testBackend("compressed");
+}
+
+TEST_F(QueryEngineTest, GridBackend) {
+    testBackend("grid");
+}
+
+TEST_F(QueryEngineTest, RangeTreeBackend) {
+    testBackend("rangetree");
+}
+
+TEST_F(QueryEngineTest, LearnedBackend) {
+    testBackend("learned");
+    testBackend("learned_morton");
+}
+
+TEST_F(QueryEngineTest, ScanKernelLevels) {
+    // The brute force scan runs on the vectorized kernels; every instruction set must agree with the database
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        ScanKernel::setSimdLevel(level);
+        std::string name = ScanKernel::simdLevelName(ScanKernel::simdLevel());
+        
+        testQuery("ScanKernel_" + name + "_Filtered", R"({
+            "valid_region": {"p_min": {"x": 100, "y": 100}, "p_max": {"x": 800, "y": 900}},
+            "query": {"operator_crop": {"region": {"p_min": {"x": 33.3, "y": 12.5}, "p_max": {"x": 777.7, "y": 654.25}},
+                                        "category": 1, "proper": false}}
+        })");
+        testQuery("ScanKernel_" + name + "_Groups", R"({
+            "valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+            "query": {"operator_crop": {"region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 500, "y": 1000}},
+                                        "one_of_groups": [0, 2, 4, 6], "proper": true}}
+        })");
+    }
+    ScanKernel::setSimdLevel(SimdLevel::AVX512);
+}
+
+TEST_F(QueryEngineTest, MorselScheduler) {
+    // Every morsel runs exactly once, also with several loops sharing the workers
+    MorselScheduler scheduler(4);
+    const size_t morsels = 10000;
+    std::vector<std::vector<std::atomic<int>>> hits;
+    for (int loop = 0; loop < 3; ++loop) {
+        hits.emplace_back(morsels);
+    }
+    
+    std::vector<std::future<void>> loops;
+    for (auto& loop_hits : hits) {
+        loops.push_back(std::async(std::launch::async, [&scheduler, &loop_hits]() {
+            scheduler.parallelFor(loop_hits.size(), [&](size_t m) { loop_hits[m]++; });
+        }));
+    }
+    for (auto& loop : loops) {
+        loop.get();
+    }
+    for (const auto& loop_hits : hits) {
+        for (size_t m = 0; m < morsels; ++m) {
+            ASSERT_EQ(loop_hits[m].load(), 1) << "Morsel " << m;
+        }
+    }
+    
+    EXPECT_THROW(scheduler.parallelFor(morsels, [](size_t m) {
+        if (m == 1234) throw std::runtime_error("morsel failed");
+    }), std::runtime_error);
+    
+    // Crops over the whole data set run in parallel on the in-memory backends
+    for (const std::string backend : {"columnar", "rtree"}) {
+        engine->selectBackend(backend);
+        testQuery("Morsels_" + backend, R"({
+            "valid_region": {"p_min": {"x": 100, "y": 100}, "p_max": {"x": 800, "y": 900}},
+            "query": {"operator_crop": {"region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+                                        "proper": false, "limit": 100000}}
+        })");
+    }
+    engine->selectBackend("database");
+}
+
+TEST_F(QueryEngineTest, PointSortMatchesStdSort) {
+    // Coarse coordinates give many equal (y, x) pairs, signed zeros and negatives; ids are shuffled
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> coord(-50, 50);
+    std::vector<Point> points;
+    for (int i = 0; i < 200000; ++i) {
+        double x = coord(rng) * 0.5;
+        double y = coord(rng) * 0.25;
+        points.emplace_back(x == 0.0 && i % 2 ? -0.0 : x, y, i, i / 10, i % 10);
+    }
+    std::shuffle(points.begin(), points.end(), rng);
+    
+    std::vector<Point> expected = points;
+    std::sort(expected.begin(), expected.end());
+    sortPoints(points);
+    
+    ASSERT_EQ(points.size(), expected.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        ASSERT_EQ(points[i].id, expected[i].id) << "Position " << i;
+    }
+    
+    EXPECT_LT(orderedKey(-1.5), orderedKey(-0.5));
+    EXPECT_EQ(orderedKey(-0.0), orderedKey(0.0));
+    EXPECT_LT(orderedKey(0.0), orderedKey(1e-300));
+    EXPECT_LT(orderedKey(2.0), orderedKey(1e300));
+}
+
+TEST_F(QueryEngineTest, LateMaterializedResults) {
+    QuerySpec spec = JsonParser::parseQueryString(R"({
+        "valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+        "query": {"operator_crop": {"region": {"p_min": {"x": 200, "y": 200}, "p_max": {"x": 600, "y": 500}}}}
+    })");
+    
+    // Brute force results are ordinals into the cached points; every result shares that table
+    QueryResult first = engine->executeQueryBruteForce(spec);
+    QueryResult second = engine->executeQueryBruteForce(spec);
+    ASSERT_FALSE(first.empty());
+    EXPECT_EQ(first.getRows().getTable(), second.getRows().getTable());
+    EXPECT_FALSE(first.getRows().coversTable());
+    
+    // Rows read in place and gathered points agree, and match the database
+    const std::vector<Point>& gathered = first.getPoints();
+    ASSERT_EQ(gathered.size(), first.getRows().size());
+    for (size_t i = 0; i < gathered.size(); ++i) {
+        ASSERT_EQ(gathered[i].id, first.getRows()[i].id);
+    }
+    compareQueryResults(engine->executeQuery(spec), first);
+    
+    // A result built from its own points uses them as the table, without ordinals
+    QueryResult owned(std::vector<Point>(gathered.begin(), gathered.begin() + 1));
+    EXPECT_TRUE(owned.getRows().coversTable());
+    EXPECT_EQ(&owned.getPoints(), owned.getRows().getTable().get());
+}
+
+TEST_F(QueryEngineTest, ZoneMapSkipsBlocks) {
+    // Block 0: x in [0, 10], group 1, category 2; block 1: x in [100, 110], group 5, category 7, one NaN x
+    std::vector<Point> points;
+    for (size_t i = 0; i < 2 * ZoneMap::BLOCK_SIZE; ++i) {
+        bool second = i >= ZoneMap::BLOCK_SIZE;
+        double x = (second ? 100.0 : 0.0) + (i % 11);
+        points.emplace_back(x, i * 0.01, i, second ? 5 : 1, second ? 7 : 2);
+    }
+    points[ZoneMap::BLOCK_SIZE + 3].x = std::nan("");
+    ZoneMap zones(points);
+    ASSERT_EQ(zones.blockCount(), 2u);
+    
+    CropFilter any;
+    ZoneMap::Probe wide(zones, Rectangle(-1, -1, 1000, 1000), any);
+    EXPECT_EQ(wide.test(0), ZoneMap::Overlap::INSIDE);
+    EXPECT_EQ(wide.test(ZoneMap::BLOCK_SIZE + 1), ZoneMap::Overlap::PARTIAL);
+    
+    ZoneMap::Probe left(zones, Rectangle(-1, -1, 50, 1000), any);
+    EXPECT_EQ(left.test(0), ZoneMap::Overlap::INSIDE);
+    ZoneMap::Probe upper(zones, Rectangle(-1, 3, 50, 1000), any);
+    EXPECT_EQ(upper.test(0), ZoneMap::Overlap::NONE);
+    
+    // The NaN keeps block 1 from being skipped or taken whole on x
+    EXPECT_EQ(left.test(ZoneMap::BLOCK_SIZE), ZoneMap::Overlap::PARTIAL);
+    
+    CropFilter by_category;
+    by_category.categories = {7};
+    ZoneMap::Probe categories(zones, Rectangle(-1, -1, 1000, 1000), by_category);
+    EXPECT_EQ(categories.test(0), ZoneMap::Overlap::NONE);
+    EXPECT_EQ(categories.test(ZoneMap::BLOCK_SIZE), ZoneMap::Overlap::PARTIAL);
+    
+    CropFilter by_group;
+    by_group.restrict_groups = true;
+    by_group.groups = {2, 3, 4};
+    by_group.sortGroups();
+    ZoneMap::Probe groups(zones, Rectangle(-1, -1, 1000, 1000), by_group);
+    EXPECT_EQ(groups.test(0), ZoneMap::Overlap::NONE);
+    EXPECT_EQ(groups.test(ZoneMap::BLOCK_SIZE), ZoneMap::Overlap::NONE);
+    
+    CropFilter excluding;
+    excluding.excluded = {1};
+    ZoneMap::Probe excluded(zones, Rectangle(-1, -1, 1000, 1000), excluding);
+    EXPECT_EQ(excluded.test(0), ZoneMap::Overlap::NONE);
+    EXPECT_EQ(excluded.test(ZoneMap::BLOCK_SIZE), ZoneMap::Overlap::PARTIAL);
+    
+    // Group-filtered crops over the whole region only read the matching blocks
+    for (const std::string backend : {"columnar", "compressed"}) {
+        engine->selectBackend(backend);
+        testQuery("ZoneMap_" + backend, R"({
+            "valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+            "query": {"operator_crop": {"region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+                                        "category": 3, "one_of_groups": [7, 11]}}
+        })");
+    }
+    engine->selectBackend("database");
+}
+
+TEST_F(QueryEngineTest, GroupIndexQueries) {
+    // Slices are in result order and cropped by y band, x, category and cursor
+    std::vector<Point> table;
+    for (int i = 0; i < 1000; ++i) {
+        table.emplace_back((i * 37) % 100, (i * 53) % 100, i, i % 7, i % 3);
+    }
+    GroupIndex index(table);
+    EXPECT_EQ(index.groupCount(), 7u);
+    
+    std::vector<size_t> groups = index.lookup({2, 5, 99});
+    ASSERT_EQ(groups.size(), 2u);
+    EXPECT_EQ(index.pointCount(groups), 286u);
+    
+    Rectangle crop(10, 20, 60, 80);
+    KeysetCursor after(30, 40, 0);
+    std::vector<uint32_t> rows = index.cropGroups(table, groups, crop, {1}, after, std::nullopt);
+    std::vector<uint32_t> expected;
+    for (uint32_t row = 0; row < table.size(); ++row) {
+        const Point& point = table[row];
+        if ((point.group_id == 2 || point.group_id == 5) && crop.contains(point) && point.category == 1 &&
+            after.precedes(point)) {
+            expected.push_back(row);
+        }
+    }
+    std::sort(expected.begin(), expected.end(), [&](uint32_t a, uint32_t b) { return table[a] < table[b]; });
+    ASSERT_FALSE(expected.empty());
+    EXPECT_EQ(rows, expected);
+    EXPECT_EQ(index.cropGroups(table, groups, crop, {1}, after, 3), std::vector<uint32_t>(expected.begin(), expected.begin() + 3));
+    
+    // A few listed groups take the group paths in SQL and brute force; both must agree, also across pages
+    testQuery("GroupIndex_Few", R"({
+        "valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+        "query": {"operator_crop": {"region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+                                    "one_of_groups": [3, 17, 42]}}
+    })");
+    testQuery("GroupIndex_Filtered", R"({
+        "valid_region": {"p_min": {"x": 100, "y": 100}, "p_max": {"x": 800, "y": 900}},
+        "query": {"operator_crop": {"region": {"p_min": {"x": 150, "y": 50}, "p_max": {"x": 700, "y": 600}},
+                                    "one_of_groups": [1, 2, 3, 4, 5], "category": 2, "proper": false,
+                                    "limit": 20, "after": {"y": 200.0, "x": 0, "id": 0}}}
+    })");
+}
+
+TEST_F(QueryEngineTest, CategoryBitmaps) {
+    // Category 1 is dense (bitset chunks), 2 is rare (array chunks), 3 only appears in the second chunk
+    std::vector<int> categories(3 * RoaringBitmap::CHUNK_ROWS);
+    for (size_t row = 0; row < categories.size(); ++row) {
+        categories[row] = row % 100 == 7 ? 2 : (row >= RoaringBitmap::CHUNK_ROWS && row % 5 == 0 ? 3 : 1);
+    }
+    CategoryIndex index(categories);
+    EXPECT_EQ(index.cardinality({2}), (categories.size() + 92) / 100);
+    EXPECT_EQ(index.cardinality({4}), 0u);
+    
+    // Aligned and unaligned ranges, across chunk boundaries, against the scan kernel
+    for (size_t first : {size_t(0), size_t(64 * 1000), size_t(12345), RoaringBitmap::CHUNK_ROWS - 100}) {
+        for (std::vector<int> filter : {std::vector<int>{1}, std::vector<int>{2, 3}, std::vector<int>{3, 3, 4}}) {
+            size_t count = 70001;
+            std::vector<uint64_t> got(ScanKernel::maskWords(count));
+            std::vector<uint64_t> expected(ScanKernel::maskWords(count), ~uint64_t(0));
+            expected.back() = (uint64_t(1) << (count % 64)) - 1;
+            index.selectMask(filter, first, count, got.data());
+            ScanKernel::andCategoryMask(categories.data() + first, count, filter, expected.data());
+            ASSERT_EQ(got, expected) << "first " << first << ", " << filter.size() << " categories";
+        }
+    }
+    
+    // Category-filtered brute force runs on the bitmaps and must agree with the database
+    testQuery("CategoryBitmaps_Crop", R"({
+        "valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+        "query": {"operator_crop": {"region": {"p_min": {"x": 123.5, "y": 0}, "p_max": {"x": 876.5, "y": 1000}},
+                                    "category": 2}}
+    })");
+}
+
+TEST_F(QueryEngineTest, CategoryMaskFilters) {
+    // category_in and category_range become one ascending list without duplicates
+    auto parseCategories = [](const std::string& fields) {
+        return JsonParser::parseQueryString(R"({"valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1, "y": 1}},
+            "query": {"operator_crop": {"region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1, "y": 1}}, )" + fields + "}}}")
+            .crop_query.category_filter;
+    };
+    EXPECT_EQ(parseCategories(R"("category_in": [9, 4, 1, 4])"), std::vector<int>({1, 4, 9}));
+    EXPECT_EQ(parseCategories(R"("category_range": {"min": -1, "max": 2})"), std::vector<int>({-1, 0, 1, 2}));
+    
+    // Only one category field per query, so combining them can never be mistaken for an intersection
+    for (const char* bad : {R"("category_in": 3)", R"("category_in": [])", R"("category_range": {"min": 5, "max": 4})",
+                            R"("category_range": {"min": 0, "max": 256})", R"("category_range": {"min": 1})",
+                            R"("category": 2, "category_range": {"min": 1, "max": 3})",
+                            R"("category": 2, "category_in": [2])",
+                            R"("category_in": [1], "category_range": {"min": 1, "max": 3})"}) {
+        std::string query = std::string(R"({"valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1, "y": 1}},
+            "query": {"operator_crop": {"region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1, "y": 1}}, )") + bad + "}}}";
+        EXPECT_THROW(JsonParser::parseQueryString(query), std::runtime_error) << bad;
+    }
+    
+    // Mask kernels on every instruction set, with categories outside 0..255 in the data and in the filter
+    std::mt19937 rng(50);
+    std::uniform_int_distribution<int> pick(-3, 300);
+    std::vector<int> categories(5000);
+    for (int& category : categories) {
+        category = pick(rng);
+    }
+    std::vector<std::vector<int>> filters = {{0}, {1, 63, 64, 200, 255}, {255, 256, -1}, {7, 1000}, {}};
+    for (int category = 0; category < CategoryMask::DOMAIN_SIZE; category += 3) {
+        filters.back().push_back(category);
+    }
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        ScanKernel::setSimdLevel(level);
+        for (const auto& filter : filters) {
+            CategoryMask allowed(filter);
+            std::vector<uint64_t> got(ScanKernel::maskWords(categories.size()), ~uint64_t(0));
+            std::vector<uint64_t> expected(got.size(), 0);
+            ScanKernel::andCategoryMask(categories.data(), categories.size(), allowed, got.data());
+            for (size_t row = 0; row < categories.size(); ++row) {
+                if (std::find(filter.begin(), filter.end(), categories[row]) != filter.end()) {
+                    expected[row / 64] |= uint64_t(1) << (row % 64);
+                }
+            }
+            got.back() &= (uint64_t(1) << (categories.size() % 64)) - 1;
+            ASSERT_EQ(got, expected) << ScanKernel::simdLevelName(ScanKernel::simdLevel()) << ", " << filter.size() << " categories";
+        }
+    }
+    ScanKernel::setSimdLevel(SimdLevel::AVX512);
+    
+    // One query for several categories, as = ANY in SQL
+    testQuery("CategoryMask_In", R"({
+        "valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+        "query": {"operator_crop": {"region": {"p_min": {"x": 50, "y": 75.5}, "p_max": {"x": 950, "y": 900}},
+                                    "category_in": [0, 2, 3], "proper": false}}
+    })");
+    testQuery("CategoryMask_Range", R"({
+        "valid_region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 1000, "y": 1000}},
+        "query": {"operator_crop": {"region": {"p_min": {"x": 0, "y": 0}, "p_max": {"x": 600, "y": 1000}},
+                                    "category_range": {"min": 1, "max": 2}, "one_of_groups": [0, 1, 2, 3]}}
+    })");
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -23,7 +23,7 @@ public:
     /**
      * Execute AND operation: intersection of all operand results
      */
-    std::vector<Point> execute(
+    PointRows execute(
         const Rectangle& valid_region,
         DatabaseManager& db_manager
     ) override;
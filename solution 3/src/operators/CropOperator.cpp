@@ -10,7 +10,7 @@ CropOperator::CropOperator(
     // QueryEngine will be created when we execute
 }
 
-std::vector<Point> CropOperator::execute(
+PointRows CropOperator::execute(
     const Rectangle& valid_region,
     DatabaseManager& db_manager
 ) {
@@ -40,13 +40,14 @@ std::vector<Point> CropOperator::execute(
         group_filter = one_of_groups.value();
     }
     
-    return db_manager.executeCropQuery(
+    // The fetched points become the table that enclosing set operations select from
+    return PointRows(db_manager.executeCropQuery(
         crop_region,
         valid_region,
         category_filter,
         group_filter,
         proper
-    );
+    ));
 }
 
 std::string CropOperator::getDescription() const {
@@ -29,7 +29,7 @@ public:
     /**
      * Execute crop operation using existing QueryEngine
      */
-    std::vector<Point> execute(
+    PointRows execute(
         const Rectangle& valid_region,
         DatabaseManager& db_manager
     ) override;
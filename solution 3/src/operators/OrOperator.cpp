@@ -1,12 +1,13 @@
 #include "OrOperator.h"
 #include <iostream>
 #include <sstream>
+#include <future>
 
 void OrOperator::addOperand(std::unique_ptr<QueryOperator> operand) {
     operands.push_back(std::move(operand));
 }
 
-std::vector<Point> OrOperator::execute(
+PointRows OrOperator::execute(
     const Rectangle& valid_region,
     DatabaseManager& db_manager
 ) {
@@ -17,22 +18,33 @@ std::vector<Point> OrOperator::execute(
     
     std::cout << "Executing OrOperator with " << operands.size() << " operands" << std::endl;
     
-    // Execute all operands and collect results
-    std::vector<std::vector<Point>> results;
-    results.reserve(operands.size());
+    // Launch all operands concurrently; DatabaseManager hands each one its own pooled connection
+    std::vector<std::future<PointRows>> pending;
+    pending.reserve(operands.size());
     
     for (size_t i = 0; i < operands.size(); ++i) {
         std::cout << "  Executing operand " << (i + 1) << ": " << operands[i]->getDescription() << std::endl;
         
-        std::vector<Point> operand_result = operands[i]->execute(valid_region, db_manager);
+        QueryOperator* operand = operands[i].get();
+        pending.push_back(std::async(std::launch::async, [operand, &valid_region, &db_manager]() {
+            return operand->execute(valid_region, db_manager);
+        }));
+    }
+    
+    // Collect results in operand order
+    std::vector<PointRows> results;
+    results.reserve(operands.size());
+    
+    for (size_t i = 0; i < pending.size(); ++i) {
+        PointRows operand_result = pending[i].get();
         
-        std::cout << "    Result: " << operand_result.size() << " points" << std::endl;
+        std::cout << "    Operand " << (i + 1) << " result: " << operand_result.size() << " points" << std::endl;
         
         results.push_back(std::move(operand_result));
     }
     
     // Compute union
-    std::vector<Point> union_result = PointSetUtils::unionPoints(results);
+    PointRows union_result = PointSetUtils::unionPoints(results);
     
     std::cout << "OrOperator result: " << union_result.size() << " points" << std::endl;
     
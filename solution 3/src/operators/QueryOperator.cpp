@@ -1,86 +1,127 @@
 #include "QueryOperator.h"
-#include <set>
 #include <algorithm>
+#include <queue>
 #include <iostream>
 
+namespace {
+
+/**
+ * First position at or after first whose point does not precede point (rows must be sorted)
+ */
+size_t lowerBound(const PointRows& rows, size_t first, const Point& point) {
+    size_t last = rows.size();
+    while (first < last) {
+        size_t middle = first + (last - first) / 2;
+        if (rows[middle] < point) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    return first;
+}
+
+} // namespace
+
 namespace PointSetUtils {
 
-std::vector<Point> intersectPoints(const std::vector<std::vector<Point>>& pointSets) {
+PointRows intersectPoints(const std::vector<PointRows>& pointSets) {
     if (pointSets.empty()) {
         return {};
     }
     
-    if (pointSets.size() == 1) {
-        return deduplicateAndSort(pointSets[0]);
+    // Walk the smallest set and look each of its points up in the others
+    size_t smallest = 0;
+    for (size_t i = 1; i < pointSets.size(); ++i) {
+        if (pointSets[i].size() < pointSets[smallest].size()) {
+            smallest = i;
+        }
     }
-    
-    // Start with first set
-    std::set<long long> commonIds;
-    for (const Point& point : pointSets[0]) {
-        commonIds.insert(point.id);
+    const PointRows& base = pointSets[smallest];
+    if (base.empty()) {
+        return {};
     }
     
-    // Intersect with each subsequent set
-    for (size_t i = 1; i < pointSets.size(); ++i) {
-        std::set<long long> currentIds;
-        for (const Point& point : pointSets[i]) {
-            currentIds.insert(point.id);
+    // Every set is sorted, so the search in each one resumes where the last one ended
+    std::vector<size_t> positions(pointSets.size(), 0);
+    std::vector<uint32_t> rows;
+    const Point* last = nullptr;
+    
+    for (size_t i = 0; i < base.size(); ++i) {
+        const Point& point = base[i];
+        if (last != nullptr && last->id == point.id) {
+            continue;
         }
         
-        // Keep only IDs that are in both sets
-        std::set<long long> intersection;
-        std::set_intersection(
-            commonIds.begin(), commonIds.end(),
-            currentIds.begin(), currentIds.end(),
-            std::inserter(intersection, intersection.begin())
-        );
+        bool in_all = true;
+        for (size_t s = 0; s < pointSets.size() && in_all; ++s) {
+            if (s == smallest) {
+                continue;
+            }
+            positions[s] = lowerBound(pointSets[s], positions[s], point);
+            in_all = positions[s] < pointSets[s].size() && pointSets[s][positions[s]].id == point.id;
+        }
         
-        commonIds = std::move(intersection);
-    }
-    
-    // Build result vector with points that have IDs in the intersection
-    std::vector<Point> result;
-    for (const Point& point : pointSets[0]) {
-        if (commonIds.find(point.id) != commonIds.end()) {
-            result.push_back(point);
+        if (in_all) {
+            rows.push_back(base.ordinal(i));
+            last = &point;
         }
     }
     
-    return deduplicateAndSort(std::move(result));
+    return PointRows(base.getTable(), std::move(rows));
 }
 
-std::vector<Point> unionPoints(const std::vector<std::vector<Point>>& pointSets) {
-    std::set<long long> seenIds;
-    std::vector<Point> result;
+PointRows unionPoints(const std::vector<PointRows>& pointSets) {
+    // Heap of (set, position) ordered by the point at that position, smallest first
+    using Cursor = std::pair<size_t, size_t>;
+    auto greater = [&pointSets](const Cursor& a, const Cursor& b) {
+        return pointSets[b.first][b.second] < pointSets[a.first][a.second];
+    };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(greater)> heap(greater);
     
-    for (const auto& pointSet : pointSets) {
-        for (const Point& point : pointSet) {
-            if (seenIds.find(point.id) == seenIds.end()) {
-                seenIds.insert(point.id);
-                result.push_back(point);
-            }
+    // Sets that all select from one table give a result of ordinals; otherwise the points are gathered
+    const PointRows* first_set = nullptr;
+    bool one_table = true;
+    for (size_t s = 0; s < pointSets.size(); ++s) {
+        if (pointSets[s].empty()) {
+            continue;
         }
+        heap.emplace(s, 0);
+        if (first_set == nullptr) {
+            first_set = &pointSets[s];
+        } else if (!first_set->sharesTable(pointSets[s])) {
+            one_table = false;
+        }
+    }
+    if (first_set == nullptr) {
+        return {};
     }
     
-    return deduplicateAndSort(std::move(result));
-}
-
-std::vector<Point> deduplicateAndSort(std::vector<Point> points) {
-    // Remove duplicates by ID
-    std::set<long long> seenIds;
-    std::vector<Point> unique;
+    std::vector<uint32_t> rows;
+    std::vector<Point> points;
+    const Point* last = nullptr;
     
-    for (const Point& point : points) {
-        if (seenIds.find(point.id) == seenIds.end()) {
-            seenIds.insert(point.id);
-            unique.push_back(point);
+    while (!heap.empty()) {
+        auto [s, i] = heap.top();
+        heap.pop();
+        if (i + 1 < pointSets[s].size()) {
+            heap.emplace(s, i + 1);
+        }
+        
+        // A point in several sets comes out of the merge once per set, back to back
+        const Point& point = pointSets[s][i];
+        if (last != nullptr && last->id == point.id) {
+            continue;
+        }
+        if (one_table) {
+            rows.push_back(pointSets[s].ordinal(i));
+        } else {
+            points.push_back(point);
         }
+        last = &point;
     }
     
-    // Sort by (y, x) as required
-    std::sort(unique.begin(), unique.end());
-    
-    return unique;
+    return one_table ? PointRows(first_set->getTable(), std::move(rows)) : PointRows(std::move(points));
 }
 
 } // namespace PointSetUtils
\ No newline at end of file
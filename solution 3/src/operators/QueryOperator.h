@@ -3,6 +3,7 @@
 #include "geometry/Point.h"
 #include "geometry/Rectangle.h"
 #include "database/DatabaseManager.h"
+#include "query/PointRows.h"
 #include <vector>
 #include <memory>
 
@@ -18,9 +19,9 @@ public:
      * Execute the operator and return matching points
      * @param valid_region The valid region from the top-level query
      * @param db_manager Database manager for executing queries
-     * @return Vector of points matching the operator criteria, sorted by (y,x)
+     * @return Rows matching the operator criteria, sorted by (y, x, id)
      */
-    virtual std::vector<Point> execute(
+    virtual PointRows execute(
         const Rectangle& valid_region,
         DatabaseManager& db_manager
     ) = 0;
@@ -32,23 +33,21 @@ public:
 };
 
 /**
- * Utility functions for set operations on Point vectors
+ * Utility functions for set operations on point sets
+ * The sets are operator results: rows sorted by (y, x, id). Results reference
+ * the operands' tables where they can, so points are only copied by a union
+ * of operands with different tables.
  */
 namespace PointSetUtils {
     /**
      * Compute intersection of multiple point sets
-     * Returns points that appear in ALL sets
+     * Returns points that appear in ALL sets, as rows of the smallest set's table
      */
-    std::vector<Point> intersectPoints(const std::vector<std::vector<Point>>& pointSets);
+    PointRows intersectPoints(const std::vector<PointRows>& pointSets);
     
     /**
      * Compute union of multiple point sets  
      * Returns points that appear in ANY set (no duplicates)
      */
-    std::vector<Point> unionPoints(const std::vector<std::vector<Point>>& pointSets);
-    
-    /**
-     * Remove duplicate points from a vector and sort by (y,x)
-     */
-    std::vector<Point> deduplicateAndSort(std::vector<Point> points);
+    PointRows unionPoints(const std::vector<PointRows>& pointSets);
 }
\ No newline at end of file